@@ -0,0 +1,721 @@
+#include "ConvolutionReverb.h"
+
+// Spectra of the real-only transforms: size / 2 + 1 bins, each half padded
+// to a multiple of 8 floats
+static constexpr int headBins = ConvolutionReverb::headSize + 1;
+static constexpr int headStride = (headBins + 7) & ~7;
+static constexpr int tailBins = ConvolutionReverb::tailSize + 1;
+static constexpr int tailStride = (tailBins + 7) & ~7;
+
+// Head partitions cover headSize .. tailOffset
+static constexpr int maxHeadPartitions =
+    (ConvolutionReverb::tailOffset - ConvolutionReverb::headSize) /
+    ConvolutionReverb::headSize;
+
+// Unit energy would be as loud as the dry signal; this sits it behind
+static constexpr float irLevel = 0.5f;
+
+static int getMaxTailPartitions(double rate) {
+  const int maxLength = (int)(ConvolutionReverb::maxIrSeconds * rate);
+  return juce::jmax(1, (maxLength - ConvolutionReverb::tailOffset +
+                        ConvolutionReverb::tailSize - 1) /
+                           ConvolutionReverb::tailSize);
+}
+
+// JUCE's real-only transforms interleave re/im
+static void toSplit(const float *interleaved, float *re, float *im,
+                    int bins) {
+  for (int i = 0; i < bins; ++i) {
+    re[i] = interleaved[2 * i];
+    im[i] = interleaved[2 * i + 1];
+  }
+}
+
+static void toInterleaved(const float *re, const float *im,
+                          float *interleaved, int bins) {
+  for (int i = 0; i < bins; ++i) {
+    interleaved[2 * i] = re[i];
+    interleaved[2 * i + 1] = im[i];
+  }
+}
+
+// acc += x * h, complex, over split spectra
+static void multiplyAdd(float *accRe, float *accIm, const float *xRe,
+                        const float *xIm, const float *hRe, const float *hIm,
+                        int numBins) {
+  for (int i = 0; i < numBins; ++i) {
+    accRe[i] += xRe[i] * hRe[i] - xIm[i] * hIm[i];
+    accIm[i] += xRe[i] * hIm[i] + xIm[i] * hRe[i];
+  }
+}
+
+ConvolutionReverb::ConvolutionReverb() {}
+
+ConvolutionReverb::~ConvolutionReverb() {
+  cancelPendingUpdate();
+  joinTailJob();
+  if (loader != nullptr)
+    loader->removeAllJobs(true, 10000);
+
+  delete pending.exchange(nullptr);
+  delete retired.exchange(nullptr);
+  delete active;
+}
+
+void ConvolutionReverb::prepare(const juce::dsp::ProcessSpec &spec) {
+  joinTailJob();
+  if (loader != nullptr)
+    loader->removeAllJobs(true, 10000);
+  buildRequested = false; // Anything it asked for is built below
+
+  sampleRate = spec.sampleRate;
+  numChannels = (int)spec.numChannels;
+  maxTailPartitions = getMaxTailPartitions(sampleRate);
+  mixParam.reset(sampleRate, 0.05);
+
+  // Anything built for the old rate is of no use now
+  delete pending.exchange(nullptr);
+  delete retired.exchange(nullptr);
+  delete active;
+  active = nullptr;
+  irSeconds = 0.0;
+  ready = false;
+
+  // Never selected: it all waits for requestStart()
+  if (!wanted.load())
+    return;
+
+  // The audio thread isn't running: build this one here, which also
+  // covers any rebuild already asked for
+  cancelPendingUpdate();
+  allocate();
+
+  builtSize = caveSize.load();
+  builtDamping = caveDamping.load();
+  active = buildKernel(sampleRate).release();
+  irSeconds = (double)active->length / sampleRate;
+  ready = true;
+}
+
+void ConvolutionReverb::allocate() {
+  heads.resize((size_t)numChannels);
+  for (auto &head : heads) {
+    head.recent.assign(2 * headSize, 0.0f);
+    head.output.assign(headSize, 0.0f);
+    head.history.assign((size_t)maxHeadPartitions * 2 * headStride, 0.0f);
+    head.tailInput.assign(2 * tailSize, 0.0f);
+    head.tailOutput.assign(tailSize, 0.0f);
+  }
+
+  tails.resize((size_t)numChannels);
+  for (auto &tail : tails) {
+    tail.input.assign(2 * tailSize, 0.0f);
+    tail.output.assign(tailSize, 0.0f);
+    tail.history.assign((size_t)maxTailPartitions * 2 * tailStride, 0.0f);
+  }
+
+  // The transforms work in place on twice their size
+  headWork.assign(4 * headSize, 0.0f);
+  headAcc.assign(2 * headStride, 0.0f);
+  tailWork.assign(4 * tailSize, 0.0f);
+  tailAcc.assign(2 * tailStride, 0.0f);
+
+  clearState();
+
+  if (loader == nullptr)
+    loader = std::make_unique<juce::ThreadPool>(1);
+}
+
+void ConvolutionReverb::setWorkerPool(WorkerPool *pool) {
+  joinTailJob();
+  workers = pool;
+}
+
+void ConvolutionReverb::requestStart() {
+  if (!wanted.exchange(true))
+    triggerAsyncUpdate();
+}
+
+void ConvolutionReverb::reset() {
+  // Not started: nothing to clear, and the message thread may be
+  // allocating it right now
+  if (!ready.load())
+    return;
+
+  joinTailJob();
+  clearState();
+}
+
+void ConvolutionReverb::clearState() {
+  for (auto &head : heads) {
+    std::fill(head.recent.begin(), head.recent.end(), 0.0f);
+    std::fill(head.output.begin(), head.output.end(), 0.0f);
+    std::fill(head.history.begin(), head.history.end(), 0.0f);
+    std::fill(head.tailInput.begin(), head.tailInput.end(), 0.0f);
+    std::fill(head.tailOutput.begin(), head.tailOutput.end(), 0.0f);
+  }
+
+  for (auto &tail : tails) {
+    std::fill(tail.output.begin(), tail.output.end(), 0.0f);
+    std::fill(tail.history.begin(), tail.history.end(), 0.0f);
+  }
+
+  headFill = 0;
+  tailFill = 0;
+  headSlot = 0;
+  tailSlot = 0;
+}
+
+void ConvolutionReverb::loadImpulseResponse(const juce::File &file) {
+  {
+    const juce::ScopedLock lock(sourceLock);
+    pendingFile = file;
+    ++sourceGeneration;
+  }
+  scheduleBuild();
+}
+
+void ConvolutionReverb::clearImpulseResponse() {
+  {
+    const juce::ScopedLock lock(sourceLock);
+    pendingFile = juce::File();
+    sourceIr.setSize(0, 0);
+    sourceRate = 0.0;
+    ++sourceGeneration;
+  }
+  fileLoaded = false;
+  scheduleBuild();
+}
+
+void ConvolutionReverb::setParameters(float size, float damping, float mix) {
+  mixParam.setTargetValue(mix);
+  caveSize = size;
+  caveDamping = damping;
+}
+
+int ConvolutionReverb::getTailSamples() const {
+  // No latency anywhere, so the tail is just the IR
+  return active != nullptr ? active->length : 0;
+}
+
+//==============================================================================
+// Audio thread
+
+void ConvolutionReverb::process(juce::AudioBuffer<float> &buffer) {
+  const int numSamples = buffer.getNumSamples();
+  if (numSamples == 0)
+    return;
+
+  // Fully dry: only keep the history filling
+  if (!isActive()) {
+    keepAlive(buffer);
+    return;
+  }
+
+  // Not started or no IR yet: dry, which for a send is nothing at all
+  const bool started = ready.load();
+  if (started)
+    swapInPendingKernel();
+  if (!started || active == nullptr) {
+    if (wetOnly)
+      buffer.clear();
+    return;
+  }
+
+  // The cave follows size and damping, a little behind: the loader
+  // rebuilds it while the current one keeps playing
+  const float size = caveSize.load();
+  const float damping = caveDamping.load();
+  if (!fileLoaded.load() && (std::abs(size - builtSize) > 0.01f ||
+                             std::abs(damping - builtDamping) > 0.01f)) {
+    builtSize = size;
+    builtDamping = damping;
+    triggerAsyncUpdate();
+  }
+
+  jassert(scratch != nullptr);
+  ScratchArena::ScopedRewind rewind(*scratch);
+  auto mix = ParameterRamp::next(mixParam, *scratch, numSamples);
+
+  // Whole-block wet signal, so the dry input stays intact until the end
+  const int channels = juce::jmin(buffer.getNumChannels(), numChannels);
+  auto **wet = static_cast<float **>(
+      scratch->allocateBytes((size_t)channels * sizeof(float *)));
+  for (int ch = 0; wet != nullptr && ch < channels; ++ch)
+    wet[ch] = scratch->allocate(numSamples);
+
+  // Arena full: no wet signal this block, the dry one passes (a send is
+  // silent)
+  if (wet == nullptr || scratch->hasOverflowed()) {
+    keepAlive(buffer);
+    if (wetOnly)
+      buffer.clear();
+    return;
+  }
+
+  convolve(buffer, wet);
+
+  // Equal dry/wet crossfade, or just the wet side as a send
+  for (int ch = 0; ch < channels; ++ch) {
+    auto *data = buffer.getWritePointer(ch);
+
+    if (wetOnly && mix.isConstant()) {
+      juce::FloatVectorOperations::copyWithMultiply(data, wet[ch], mix.value,
+                                                    numSamples);
+    } else if (wetOnly) {
+      juce::FloatVectorOperations::multiply(data, wet[ch], mix.values,
+                                            numSamples);
+    } else if (mix.isConstant()) {
+      juce::FloatVectorOperations::multiply(data, 1.0f - mix.value,
+                                            numSamples);
+      juce::FloatVectorOperations::addWithMultiply(data, wet[ch], mix.value,
+                                                   numSamples);
+    } else {
+      for (int i = 0; i < numSamples; ++i)
+        data[i] += mix.values[i] * (wet[ch][i] - data[i]);
+    }
+  }
+}
+
+void ConvolutionReverb::keepAlive(const juce::AudioBuffer<float> &buffer) {
+  if (buffer.getNumSamples() == 0 || !ready.load())
+    return;
+
+  swapInPendingKernel();
+  if (active != nullptr)
+    convolve(buffer, nullptr);
+}
+
+void ConvolutionReverb::convolve(const juce::AudioBuffer<float> &buffer,
+                                 float *const *wet) {
+  const int numSamples = buffer.getNumSamples();
+  const int channels = juce::jmin(buffer.getNumChannels(), numChannels);
+  const bool withOutput = wet != nullptr;
+
+  // In chunks that end on head block boundaries (tail boundaries are
+  // head boundaries too)
+  for (int pos = 0; pos < numSamples;) {
+    const int len = juce::jmin(headSize - headFill, numSamples - pos);
+
+    for (int ch = 0; ch < channels; ++ch) {
+      auto &head = heads[(size_t)ch];
+      const auto *in = buffer.getReadPointer(ch, pos);
+      float *x = head.recent.data() + headSize + headFill;
+
+      juce::FloatVectorOperations::copy(x, in, len);
+      juce::FloatVectorOperations::copy(
+          head.tailInput.data() + tailSize + tailFill, in, len);
+
+      if (!withOutput)
+        continue;
+
+      // Both partitioned stages were worked out a block ahead...
+      float *out = wet[ch] + pos;
+      juce::FloatVectorOperations::add(out, head.output.data() + headFill,
+                                       head.tailOutput.data() + tailFill,
+                                       len);
+
+      // ...and the first taps can't wait, so they run directly: one
+      // vectorised pass over the chunk per tap
+      const int irChannel = juce::jmin(ch, active->numChannels - 1);
+      const float *taps = active->direct.getReadPointer(irChannel);
+      for (int k = 0; k < headSize; ++k)
+        juce::FloatVectorOperations::addWithMultiply(out, x - k, taps[k],
+                                                     len);
+    }
+
+    pos += len;
+    headFill += len;
+    tailFill += len;
+
+    if (headFill == headSize)
+      endHeadBlock(withOutput);
+    if (tailFill == tailSize)
+      endTailBlock(withOutput);
+  }
+}
+
+void ConvolutionReverb::endHeadBlock(bool withOutput) {
+  for (size_t ch = 0; ch < heads.size(); ++ch) {
+    auto &head = heads[ch];
+    float *slot = head.history.data() + (size_t)headSlot * 2 * headStride;
+
+    // Overlap-save: the last two blocks in, the second half out
+    juce::FloatVectorOperations::copy(headWork.data(), head.recent.data(),
+                                      2 * headSize);
+    juce::FloatVectorOperations::clear(headWork.data() + 2 * headSize,
+                                       2 * headSize);
+    headFft.performRealOnlyForwardTransform(headWork.data(), true);
+    toSplit(headWork.data(), slot, slot + headStride, headBins);
+
+    if (withOutput) {
+      const int irChannel =
+          juce::jmin((int)ch, active->numChannels - 1);
+      const float *spectra = active->head[(size_t)irChannel].data();
+      float *accRe = headAcc.data();
+      float *accIm = accRe + headStride;
+      juce::FloatVectorOperations::clear(accRe, 2 * headStride);
+
+      // Partition p meets the input from p blocks ago
+      for (int p = 0; p < active->headPartitions; ++p) {
+        const int past = (headSlot - p + maxHeadPartitions) % maxHeadPartitions;
+        const float *x = head.history.data() + (size_t)past * 2 * headStride;
+        const float *h = spectra + (size_t)p * 2 * headStride;
+        multiplyAdd(accRe, accIm, x, x + headStride, h, h + headStride,
+                    headStride);
+      }
+
+      toInterleaved(accRe, accIm, headWork.data(), headBins);
+      headFft.performRealOnlyInverseTransform(headWork.data());
+      juce::FloatVectorOperations::copy(head.output.data(),
+                                        headWork.data() + headSize, headSize);
+    } else {
+      juce::FloatVectorOperations::clear(head.output.data(), headSize);
+    }
+
+    // This block becomes the previous one
+    juce::FloatVectorOperations::copy(head.recent.data(),
+                                      head.recent.data() + headSize, headSize);
+  }
+
+  headSlot = (headSlot + 1) % maxHeadPartitions;
+  headFill = 0;
+}
+
+void ConvolutionReverb::endTailBlock(bool withOutput) {
+  // The last job worked out the block about to start
+  joinTailJob();
+
+  for (size_t ch = 0; ch < heads.size(); ++ch) {
+    auto &head = heads[ch];
+    auto &tail = tails[ch];
+
+    juce::FloatVectorOperations::copy(head.tailOutput.data(),
+                                      tail.output.data(), tailSize);
+    juce::FloatVectorOperations::copy(tail.input.data(),
+                                      head.tailInput.data(), 2 * tailSize);
+    juce::FloatVectorOperations::copy(head.tailInput.data(),
+                                      head.tailInput.data() + tailSize,
+                                      tailSize);
+  }
+
+  // No job holds a kernel now, so a new IR can come in
+  swapInPendingKernel();
+
+  // This one is heard from the block after next. Without a pool it runs
+  // here and now.
+  jobKernel = active;
+  jobWithOutput = withOutput;
+  if (workers != nullptr) {
+    workers->requestWorkers();
+    workers->start(tailBatch, &ConvolutionReverb::runTailTask, this, 1);
+  } else {
+    runTailJob();
+  }
+
+  tailFill = 0;
+}
+
+void ConvolutionReverb::joinTailJob() {
+  if (workers != nullptr)
+    workers->join(tailBatch);
+}
+
+void ConvolutionReverb::swapInPendingKernel() {
+  // Until the loader has freed the last one there's nowhere to put the
+  // one being replaced. A tail job may still be reading the current one:
+  // then it waits for the next tail boundary.
+  if (pending.load() == nullptr || retired.load() != nullptr ||
+      tailBatch.isRunning())
+    return;
+
+  auto *next = pending.exchange(nullptr);
+  if (next == nullptr)
+    return;
+
+  // Built before a sample rate change
+  if (next->sampleRate != sampleRate) {
+    retired.store(next);
+    return;
+  }
+
+  // The history is just past input, so it carries straight over to the
+  // new IR
+  retired.store(active);
+  active = next;
+  irSeconds = (double)active->length / sampleRate;
+}
+
+//==============================================================================
+// Tail job
+
+void ConvolutionReverb::runTailTask(void *context, int) {
+  static_cast<ConvolutionReverb *>(context)->runTailJob();
+}
+
+void ConvolutionReverb::runTailJob() {
+  const int partitions = jobWithOutput ? jobKernel->tailPartitions : 0;
+
+  for (size_t ch = 0; ch < tails.size(); ++ch) {
+    auto &tail = tails[ch];
+    float *slot = tail.history.data() + (size_t)tailSlot * 2 * tailStride;
+
+    juce::FloatVectorOperations::copy(tailWork.data(), tail.input.data(),
+                                      2 * tailSize);
+    juce::FloatVectorOperations::clear(tailWork.data() + 2 * tailSize,
+                                       2 * tailSize);
+    tailFft.performRealOnlyForwardTransform(tailWork.data(), true);
+    toSplit(tailWork.data(), slot, slot + tailStride, tailBins);
+
+    if (partitions == 0) {
+      juce::FloatVectorOperations::clear(tail.output.data(), tailSize);
+      continue;
+    }
+
+    const int irChannel = juce::jmin((int)ch, jobKernel->numChannels - 1);
+    const float *spectra = jobKernel->tail[(size_t)irChannel].data();
+    float *accRe = tailAcc.data();
+    float *accIm = accRe + tailStride;
+    juce::FloatVectorOperations::clear(accRe, 2 * tailStride);
+
+    for (int q = 0; q < partitions; ++q) {
+      const int past = (tailSlot - q + maxTailPartitions) % maxTailPartitions;
+      const float *x = tail.history.data() + (size_t)past * 2 * tailStride;
+      const float *h = spectra + (size_t)q * 2 * tailStride;
+      multiplyAdd(accRe, accIm, x, x + tailStride, h, h + tailStride,
+                  tailStride);
+    }
+
+    toInterleaved(accRe, accIm, tailWork.data(), tailBins);
+    tailFft.performRealOnlyInverseTransform(tailWork.data());
+    juce::FloatVectorOperations::copy(tail.output.data(),
+                                      tailWork.data() + tailSize, tailSize);
+  }
+
+  tailSlot = (tailSlot + 1) % maxTailPartitions;
+}
+
+//==============================================================================
+// Loader
+
+void ConvolutionReverb::handleAsyncUpdate() {
+  // First selection: everything the audio thread needs, before it's told
+  // to use it. The IR follows from the loader.
+  if (wanted.load() && !ready.load()) {
+    allocate();
+    ready = true;
+  }
+
+  // The IR for first use, or a cave that has moved
+  scheduleBuild();
+}
+
+void ConvolutionReverb::scheduleBuild() {
+  // Not started: a file is kept and built from on first selection
+  if (loader == nullptr)
+    return;
+
+  // One job at a time; requests made while it runs make it go round again
+  if (!buildRequested.exchange(true))
+    loader->addJob([this] { buildPending(); });
+}
+
+void ConvolutionReverb::buildPending() {
+  while (buildRequested.exchange(false)) {
+    auto kernel = buildKernel(sampleRate);
+
+    // Whatever the audio thread has let go of, and a pending one it never
+    // picked up, can go now
+    delete retired.exchange(nullptr);
+    delete pending.exchange(kernel.release());
+  }
+}
+
+std::unique_ptr<ConvolutionReverb::Kernel>
+ConvolutionReverb::buildKernel(double rate) {
+  // Only held for the hand-overs, never while reading or resampling
+  juce::File file;
+  int generation = 0;
+  {
+    const juce::ScopedLock lock(sourceLock);
+    file = pendingFile;
+    generation = sourceGeneration;
+    pendingFile = juce::File();
+  }
+
+  if (file != juce::File()) {
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+    std::unique_ptr<juce::AudioFormatReader> reader(
+        formats.createReaderFor(file));
+
+    // An unreadable file leaves the current IR as it was
+    if (reader != nullptr && reader->lengthInSamples > 0) {
+      const int length = (int)juce::jmin(
+          reader->lengthInSamples,
+          (juce::int64)(maxIrSeconds * reader->sampleRate));
+      const int channels = (int)juce::jmin(reader->numChannels, 2u);
+
+      juce::AudioBuffer<float> audio(channels, length);
+      reader->read(&audio, 0, length, 0, true, channels > 1);
+
+      // Unless it was replaced or cleared while it was being read
+      const juce::ScopedLock lock(sourceLock);
+      if (generation == sourceGeneration) {
+        sourceIr = std::move(audio);
+        sourceRate = reader->sampleRate;
+      }
+    }
+  }
+
+  juce::AudioBuffer<float> source;
+  double rateOfSource = 0.0;
+  {
+    const juce::ScopedLock lock(sourceLock);
+    source.makeCopyOf(sourceIr);
+    rateOfSource = sourceRate;
+  }
+
+  juce::AudioBuffer<float> ir;
+
+  if (source.getNumSamples() > 0 && rateOfSource == rate) {
+    ir = std::move(source);
+  } else if (source.getNumSamples() > 0) {
+    // ResamplingAudioSource filters before it drops the rate
+    const double ratio = rateOfSource / rate;
+    const int length = (int)std::ceil(source.getNumSamples() / ratio);
+
+    juce::MemoryAudioSource memory(source, false);
+    juce::ResamplingAudioSource resampler(&memory, false,
+                                          source.getNumChannels());
+    resampler.setResamplingRatio(ratio);
+    resampler.prepareToPlay(length, rate);
+
+    ir.setSize(source.getNumChannels(), length);
+    juce::AudioSourceChannelInfo info(&ir, 0, length);
+    resampler.getNextAudioBlock(info);
+  }
+
+  fileLoaded = ir.getNumSamples() > 0;
+  if (ir.getNumSamples() == 0)
+    ir = generateCave(rate);
+
+  auto kernel = std::make_unique<Kernel>();
+  kernel->sampleRate = rate;
+  kernel->numChannels = ir.getNumChannels();
+  kernel->length =
+      juce::jmin(ir.getNumSamples(), (int)(maxIrSeconds * rate));
+
+  const int length = kernel->length;
+  kernel->headPartitions = juce::jlimit(
+      0, maxHeadPartitions, (length - headSize + headSize - 1) / headSize);
+  kernel->tailPartitions =
+      juce::jlimit(0, getMaxTailPartitions(rate),
+                   (length - tailOffset + tailSize - 1) / tailSize);
+
+  // Same loudness whatever the IR: unit energy per channel, then irLevel
+  double energy = 0.0;
+  for (int ch = 0; ch < kernel->numChannels; ++ch)
+    for (int i = 0; i < length; ++i)
+      energy += (double)ir.getSample(ch, i) * ir.getSample(ch, i);
+  const float gain =
+      energy > 0.0
+          ? irLevel / (float)std::sqrt(energy / kernel->numChannels)
+          : 0.0f;
+  ir.applyGain(0, length, gain);
+
+  kernel->direct.setSize(kernel->numChannels, headSize);
+  kernel->direct.clear();
+
+  // Its own transforms: the audio thread and tail job are using theirs
+  juce::dsp::FFT headTransform(7);  // 2 * headSize
+  juce::dsp::FFT tailTransform(11); // 2 * tailSize
+  std::vector<float> work((size_t)(4 * tailSize));
+
+  // Zero-padded to twice its size, transformed and split
+  auto transform = [&](juce::dsp::FFT &fft, const float *segment,
+                       int segmentLength, int partitionSize, float *dest,
+                       int stride) {
+    std::fill(work.begin(), work.end(), 0.0f);
+    std::copy(segment, segment + segmentLength, work.begin());
+    fft.performRealOnlyForwardTransform(work.data(), true);
+    toSplit(work.data(), dest, dest + stride, partitionSize + 1);
+  };
+
+  for (int ch = 0; ch < kernel->numChannels; ++ch) {
+    const float *h = ir.getReadPointer(ch);
+
+    kernel->direct.copyFrom(ch, 0, h, juce::jmin(headSize, length));
+
+    auto &head = kernel->head.emplace_back(
+        (size_t)kernel->headPartitions * 2 * headStride, 0.0f);
+    for (int p = 0; p < kernel->headPartitions; ++p) {
+      const int start = headSize * (p + 1);
+      transform(headTransform, h + start,
+                juce::jmin(headSize, length - start), headSize,
+                head.data() + (size_t)p * 2 * headStride, headStride);
+    }
+
+    auto &tail = kernel->tail.emplace_back(
+        (size_t)kernel->tailPartitions * 2 * tailStride, 0.0f);
+    for (int q = 0; q < kernel->tailPartitions; ++q) {
+      const int start = tailOffset + tailSize * q;
+      transform(tailTransform, h + start,
+                juce::jmin(tailSize, length - start), tailSize,
+                tail.data() + (size_t)q * 2 * tailStride, tailStride);
+    }
+  }
+
+  return kernel;
+}
+
+juce::AudioBuffer<float> ConvolutionReverb::generateCave(double rate) const {
+  // Same decay times as FdnReverb's size: 0.5 s .. 10 s to -60 dB. Damping
+  // shortens the highs, down to a tenth of that.
+  const double rt60 = 0.5 * std::pow(20.0, (double)caveSize.load());
+  const double rt60High = rt60 * (1.0 - 0.9 * caveDamping.load());
+  const int length = (int)(juce::jmin(rt60, maxIrSeconds) * rate);
+
+  const double lowDecay = std::pow(10.0, -3.0 / (rt60 * rate));
+  const double highDecay = std::pow(10.0, -3.0 / (rt60High * rate));
+  const float splitCoeff =
+      1.0f - (float)std::exp(-juce::MathConstants<double>::twoPi * 1500.0 /
+                             rate);
+
+  // Diffuse sound builds up over the first 40 ms, after a few discrete
+  // echoes off the walls
+  const int onset = (int)(0.01 * rate);
+  const int buildUp = (int)(0.04 * rate);
+
+  juce::AudioBuffer<float> ir(2, juce::jmax(length, 1));
+  ir.clear();
+
+  for (int ch = 0; ch < 2; ++ch) {
+    juce::Random random(0x5ca1ab1e + ch); // The same cave every time
+    auto *h = ir.getWritePointer(ch);
+
+    double low = 1.0, high = 1.0;
+    float lowBand = 0.0f;
+
+    for (int i = onset; i < length; ++i) {
+      const float noise = random.nextFloat() * 2.0f - 1.0f;
+      lowBand += splitCoeff * (noise - lowBand);
+
+      const float fadeIn =
+          juce::jmin(1.0f, (float)(i - onset) / (float)buildUp);
+      h[i] = fadeIn * ((float)low * lowBand +
+                       (float)high * (noise - lowBand));
+      low *= lowDecay;
+      high *= highDecay;
+    }
+
+    for (int echo = 0; echo < 8; ++echo) {
+      const int at = (int)((0.008 + 0.06 * random.nextDouble()) * rate);
+      if (at < length)
+        h[at] += (random.nextBool() ? 0.6f : -0.6f) *
+                 (float)std::pow(lowDecay, at);
+    }
+  }
+
+  return ir;
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "ParameterRamp.h"
+#include "ScratchArena.h"
+#include "WorkerPool.h"
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Convolution reverb with a non-uniformly partitioned impulse response, so
+    it adds no latency and the audio thread's share of the work doesn't
+    grow with the IR's length:
+
+      - the first headSize taps run as a direct FIR, sample by sample
+      - up to tailOffset, headSize partitions are convolved in the
+        frequency domain on the audio thread, once per headSize samples
+      - everything after that runs in tailSize partitions as a job on the
+        shared WorkerPool. Each tail block is handed over once it has been
+        collected and is only heard a whole block later, so a worker has a
+        block's worth of time to finish it. If none has claimed it by the
+        time its output is due (a host block longer than tailSize, or no
+        workers running), the audio thread runs it itself rather than wait.
+
+    The IR is either a file or, by default, a cave generated from the size
+    and damping. Reading, resampling to the host rate and transforming the
+    partitions all happen on a loader thread; the audio thread picks the
+    finished IR up between tail jobs with one atomic exchange, and hands
+    the old one back to the loader to free.
+
+    Nothing is allocated or started until the reverb is first selected
+    (see requestStart); until the IR is there it passes the signal dry.
+*/
+class ConvolutionReverb : private juce::AsyncUpdater {
+public:
+  static constexpr int headSize = 64;
+  static constexpr int tailSize = 1024;
+  // The tail partitions must start at least two tail blocks in (one to
+  // collect the input, one for the worker)
+  static constexpr int tailOffset = 2 * tailSize;
+  static constexpr double maxIrSeconds = 10.0;
+
+  ConvolutionReverb();
+  ~ConvolutionReverb() override;
+
+  // Message thread. Once the reverb has been selected, builds the current
+  // IR for this rate straight away.
+  void prepare(const juce::dsp::ProcessSpec &spec);
+  void reset();
+  // Audio thread: the reverb slot has switched to convolution. The first
+  // call has the message thread allocate, start the loader and build the
+  // IR.
+  void requestStart();
+  void setScratchArena(ScratchArena *arena) { scratch = arena; }
+  // Message thread, while the audio thread is stopped. Joins a tail job
+  // still out on the old pool.
+  void setWorkerPool(WorkerPool *pool);
+
+  // Message thread: the file is read and prepared in the background; the
+  // current IR keeps playing until the new one is ready
+  void loadImpulseResponse(const juce::File &file);
+  // Back to the generated cave
+  void clearImpulseResponse();
+
+  // All 0..1. Size and damping shape the generated cave (rebuilt in the
+  // background when they move); a loaded file ignores them.
+  void setParameters(float size, float damping, float mix);
+  // As a send: outputs only the reverb, scaled by the mix
+  void setWetOnly(bool enabled) { wetOnly = enabled; }
+
+  void process(juce::AudioBuffer<float> &buffer);
+
+  // Mix up, or on its way down
+  bool isActive() const {
+    return mixParam.isSmoothing() || mixParam.getTargetValue() > 0.0f;
+  }
+  // While inactive: keeps the input history (the spectra of past blocks)
+  // up to date but skips the convolution itself, so turning the mix back
+  // up starts from a live tail
+  void keepAlive(const juce::AudioBuffer<float> &buffer);
+
+  // The whole IR, as it can still ring out of the history
+  int getTailSamples() const;
+  // The same for the host, in seconds
+  double getTailSeconds() const { return irSeconds.load(); }
+
+private:
+  // One prepared IR at one sample rate. The spectra are split into real
+  // and imaginary halves (stride floats each, zero padded) so the complex
+  // multiply-adds vectorise.
+  struct Kernel {
+    double sampleRate = 0.0;
+    int length = 0;
+    int numChannels = 0;
+    int headPartitions = 0;
+    int tailPartitions = 0;
+    juce::AudioBuffer<float> direct; // The first headSize taps
+    std::vector<std::vector<float>> head, tail; // Per IR channel
+  };
+
+  // Audio thread side of one channel
+  struct HeadChannel {
+    std::vector<float> recent;     // Last two head blocks of input
+    std::vector<float> output;     // Head partitions' output, this block
+    std::vector<float> history;    // Spectra of past head blocks
+    std::vector<float> tailInput;  // Last two tail blocks of input
+    std::vector<float> tailOutput; // Tail job's output, this tail block
+  };
+
+  // Tail job side of one channel
+  struct TailChannel {
+    std::vector<float> input;   // Handed over at each tail boundary
+    std::vector<float> output;  // Picked up at the next one
+    std::vector<float> history; // Spectra of past tail blocks
+  };
+
+  void handleAsyncUpdate() override;
+
+  // Message thread
+  void allocate();
+
+  // Audio thread. The tail job in flight: run here if no worker has
+  // claimed it, else spun on until the worker is done with it.
+  void joinTailJob();
+  void swapInPendingKernel();
+  void clearState();
+
+  // Feeds the input in; fills `wet` with the convolution if given
+  void convolve(const juce::AudioBuffer<float> &buffer, float *const *wet);
+  void endHeadBlock(bool withOutput);
+  void endTailBlock(bool withOutput);
+  // On whichever thread claimed the job
+  static void runTailTask(void *context, int index);
+  void runTailJob();
+
+  // Loader thread
+  void scheduleBuild();
+  void buildPending();
+  std::unique_ptr<Kernel> buildKernel(double rate);
+  juce::AudioBuffer<float> generateCave(double rate) const;
+
+  ScratchArena *scratch = nullptr;
+
+  juce::LinearSmoothedValue<float> mixParam;
+  std::atomic<float> caveSize{0.5f}, caveDamping{0.5f};
+  float builtSize = 0.5f, builtDamping = 0.5f; // Audio thread's last request
+  bool wetOnly = false;
+
+  double sampleRate = 44100.0;
+  int numChannels = 0;
+  int maxTailPartitions = 0;
+
+  // Audio thread
+  Kernel *active = nullptr;
+  std::vector<HeadChannel> heads;
+  juce::dsp::FFT headFft{7}; // 2 * headSize
+  std::vector<float> headWork, headAcc;
+  int headFill = 0;
+  int tailFill = 0;
+  int headSlot = 0;
+
+  // Buffers allocated, by the message thread
+  std::atomic<bool> ready{false};
+  // Selected at least once: prepare() allocates up front from then on
+  std::atomic<bool> wanted{false};
+
+  // Tail job, one per tail block
+  WorkerPool *workers = nullptr;
+  WorkerPool::Batch tailBatch;
+  std::vector<TailChannel> tails;
+  juce::dsp::FFT tailFft{11}; // 2 * tailSize
+  std::vector<float> tailWork, tailAcc;
+  int tailSlot = 0;
+  const Kernel *jobKernel = nullptr;
+  bool jobWithOutput = true;
+
+  // Loader, created on first use. pending is a finished IR waiting for the
+  // audio thread; retired one it has let go of, deleted by the loader
+  // before it publishes again.
+  std::unique_ptr<juce::ThreadPool> loader;
+  std::atomic<bool> buildRequested{false};
+  std::atomic<Kernel *> pending{nullptr};
+  std::atomic<Kernel *> retired{nullptr};
+  std::atomic<double> irSeconds{0.0};
+  std::atomic<bool> fileLoaded{false};
+
+  // What to build from: a file still to read, the file's audio (at its own
+  // rate), or nothing for the cave. The generation counts loads and clears,
+  // so a file that finishes reading after it was replaced is dropped.
+  juce::CriticalSection sourceLock;
+  juce::File pendingFile;
+  int sourceGeneration = 0;
+  juce::AudioBuffer<float> sourceIr;
+  double sourceRate = 0.0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConvolutionReverb)
+};
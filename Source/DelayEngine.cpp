@@ -0,0 +1,424 @@
+#include "DelayEngine.h"
+
+// Beats per repeat for each sync division (see getDivisionNames)
+static constexpr double divisionBeats[] = {4.0, 2.0, 1.0, 0.5,
+                                           0.75, 1.0 / 3.0, 0.25};
+
+DelayEngine::~DelayEngine() { cancelPendingUpdate(); }
+
+juce::StringArray DelayEngine::getDivisionNames() {
+  return {"1/1", "1/2", "1/4", "1/8", "1/8 Dotted", "1/8 Triplet", "1/16"};
+}
+
+void DelayEngine::prepare(const juce::dsp::ProcessSpec &spec) {
+  cancelPendingUpdate();
+
+  sampleRate = spec.sampleRate;
+  numPreparedChannels = (int)spec.numChannels;
+  // The longest delay plus the sample interpolation reads next to it
+  ringSize = juce::nextPowerOfTwo(
+      (int)std::ceil(maxDelayTime * sampleRate) + 2);
+  ringMask = ringSize - 1;
+  toneState.assign((size_t)numPreparedChannels, 0.0f);
+
+  timeParam.reset(sampleRate, 0.05);
+  feedbackParam.reset(sampleRate, 0.05);
+  mixParam.reset(sampleRate, 0.05);
+  updateToneCoeff();
+
+  // Already in use (or about to be): re-size now rather than go dry
+  if (allocated.load() || mixParam.getTargetValue() > 0.0f) {
+    allocated = false;
+    allocate();
+  }
+
+  reset();
+}
+
+void DelayEngine::reset() {
+  writePos = 0;
+  if (allocated.load())
+    clearRing();
+}
+
+void DelayEngine::allocate() {
+  ring.setSize(numPreparedChannels, ringSize);
+  ring.clear();
+  ringChannels = ring.getArrayOfWritePointers();
+  allocated = true;
+}
+
+void DelayEngine::handleAsyncUpdate() {
+  if (!allocated.load())
+    allocate();
+}
+
+void DelayEngine::clearRing() {
+  for (int ch = 0; ch < ring.getNumChannels(); ++ch)
+    juce::FloatVectorOperations::clear(ringChannels[ch], ringSize);
+  std::fill(toneState.begin(), toneState.end(), 0.0f);
+}
+
+void DelayEngine::setParameters(float timeSeconds, float feedback,
+                                float mix) {
+  freeTime = timeSeconds;
+  updateTimeTarget();
+  feedbackParam.setTargetValue(feedback);
+  mixParam.setTargetValue(mix);
+
+  // First use: the message thread allocates, the delay stays dry till then
+  if (mix > 0.0f && !allocated.load())
+    triggerAsyncUpdate();
+}
+
+void DelayEngine::setTempoSync(bool enabled, int division, double bpm) {
+  syncEnabled = enabled;
+  syncDivision = juce::jlimit(0, (int)std::size(divisionBeats) - 1, division);
+  hostBpm = bpm;
+  updateTimeTarget();
+}
+
+void DelayEngine::setTone(float newTone) {
+  newTone = juce::jlimit(0.0f, 1.0f, newTone);
+  if (newTone == tone)
+    return;
+
+  tone = newTone;
+  updateToneCoeff();
+}
+
+void DelayEngine::updateToneCoeff() {
+  // Fully open is no filter at all
+  if (tone >= 1.0f) {
+    toneCoeff = 1.0f;
+    return;
+  }
+
+  const double cutoff = 500.0 * std::pow(40.0, (double)tone);
+  toneCoeff = (float)(1.0 - std::exp(-juce::MathConstants<double>::twoPi *
+                                     cutoff / sampleRate));
+}
+
+void DelayEngine::updateTimeTarget() {
+  const float seconds = syncEnabled
+                            ? (float)getSyncedSeconds(syncDivision, hostBpm)
+                            : freeTime;
+  timeParam.setTargetValue(juce::jlimit(0.0f, maxDelayTime, seconds));
+}
+
+double DelayEngine::getSyncedSeconds(int division, double bpm) {
+  division = juce::jlimit(0, (int)std::size(divisionBeats) - 1, division);
+  return divisionBeats[division] * 60.0 / (bpm < 20.0 ? 120.0 : bpm);
+}
+
+int DelayEngine::getTailSamples() const {
+  // Never turned up: nothing stored
+  return allocated.load() ? ringSize : 0;
+}
+
+double DelayEngine::getTailSeconds(double delaySeconds, double feedback) {
+  delaySeconds = juce::jlimit(0.0, (double)maxDelayTime, delaySeconds);
+  if (feedback <= 0.0)
+    return delaySeconds;
+
+  // Each repeat is 20 log10(feedback) dB down on the last
+  const double repeats =
+      std::ceil(-100.0 / (20.0 * std::log10(juce::jmin(feedback, 0.999))));
+  return delaySeconds * (1.0 + repeats);
+}
+
+void DelayEngine::process(juce::AudioBuffer<float> &buffer) {
+  const int numSamples = buffer.getNumSamples();
+  if (numSamples == 0)
+    return;
+
+  // Still waiting for the ring: dry, which for a send is nothing at all
+  if (!allocated.load()) {
+    if (wetOnly)
+      buffer.clear();
+    return;
+  }
+
+  // Mix off: nothing to hear, so only keep the ring filling
+  if (!isActive()) {
+    keepAlive(buffer);
+    return;
+  }
+
+  jassert(scratch != nullptr);
+  ScratchArena::ScopedRewind rewind(*scratch);
+  auto time = ParameterRamp::next(timeParam, *scratch, numSamples);
+  auto feedback = ParameterRamp::next(feedbackParam, *scratch, numSamples);
+  auto mix = ParameterRamp::next(mixParam, *scratch, numSamples);
+
+  const int numChannels =
+      juce::jmin(buffer.getNumChannels(), ring.getNumChannels());
+  auto *channels = buffer.getArrayOfWritePointers();
+  const float rate = (float)sampleRate;
+  const float maxDelaySamples = maxDelayTime * rate;
+
+  bool processed = false;
+  if (time.isConstant()) {
+    processed = processSpans(
+        channels, numChannels, numSamples,
+        juce::jlimit(1.0f, maxDelaySamples, time.value * rate), feedback, mix);
+  } else {
+    auto *delaySamples = time.values;
+    juce::FloatVectorOperations::multiply(delaySamples, rate, numSamples);
+    juce::FloatVectorOperations::clip(delaySamples, delaySamples, 1.0f,
+                                      maxDelaySamples, numSamples);
+    processed = processRamping(channels, numChannels, numSamples,
+                               delaySamples, feedback, mix);
+  }
+
+  // Arena full: no echoes this block, the dry signal passes (a send is
+  // silent)
+  if (!processed) {
+    keepAlive(buffer);
+    if (wetOnly)
+      buffer.clear();
+    return;
+  }
+
+  writePos = (writePos + numSamples) & ringMask;
+}
+
+void DelayEngine::keepAlive(const juce::AudioBuffer<float> &buffer) {
+  const int numSamples = buffer.getNumSamples();
+  if (numSamples == 0 || !allocated.load())
+    return;
+
+  // Time and feedback land where they're headed while nobody listens
+  timeParam.skip(numSamples);
+  feedbackParam.skip(numSamples);
+
+  const int numChannels =
+      juce::jmin(buffer.getNumChannels(), ring.getNumChannels());
+
+  // What process() writes with no feedback: the input as it is, or with
+  // ping-pong its mono sum into the first channel and silence elsewhere.
+  // Whole blocks may be longer than the ring, so only the last ringSize
+  // samples are written.
+  const int skipped = juce::jmax(0, numSamples - ringSize);
+  const int len = numSamples - skipped;
+  const int start = writePos + skipped;
+
+  if (pingPong && numChannels > 1) {
+    const float inputScale = 1.0f / (float)numChannels;
+    const int first = start & ringMask;
+    const int head = juce::jmin(len, ringSize - first);
+
+    for (int ch = 0; ch < numChannels; ++ch) {
+      juce::FloatVectorOperations::clear(ringChannels[ch] + first, head);
+      juce::FloatVectorOperations::clear(ringChannels[ch], len - head);
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch) {
+      const auto *input = buffer.getReadPointer(ch, skipped);
+      juce::FloatVectorOperations::addWithMultiply(ringChannels[0] + first,
+                                                   input, inputScale, head);
+      juce::FloatVectorOperations::addWithMultiply(
+          ringChannels[0], input + head, inputScale, len - head);
+    }
+  } else {
+    for (int ch = 0; ch < numChannels; ++ch)
+      writeSpan(ch, start, buffer.getReadPointer(ch, skipped), len);
+  }
+
+  writePos = (writePos + numSamples) & ringMask;
+}
+
+bool DelayEngine::processSpans(float *const *channels, int numChannels,
+                               int numSamples, float delaySamples,
+                               const ParameterRamp &feedback,
+                               const ParameterRamp &mix) {
+  const int delayInt = (int)delaySamples;
+  const float frac = delaySamples - (float)delayInt;
+
+  // No span is longer than the delay, so everything it reads was written
+  // before it starts
+  const int maxSpan = juce::jmin(numSamples, delayInt);
+  auto **delayed = static_cast<float **>(
+      scratch->allocateBytes((size_t)numChannels * sizeof(float *)));
+  auto **feedbackOut = static_cast<float **>(
+      scratch->allocateBytes((size_t)numChannels * sizeof(float *)));
+  for (int ch = 0; delayed != nullptr && feedbackOut != nullptr &&
+                  ch < numChannels;
+       ++ch) {
+    delayed[ch] = scratch->allocate(maxSpan);
+    feedbackOut[ch] = scratch->allocate(maxSpan);
+  }
+  auto *older = scratch->allocate(maxSpan);
+  if (delayed == nullptr || feedbackOut == nullptr || scratch->hasOverflowed())
+    return false;
+
+  for (int offset = 0; offset < numSamples; offset += maxSpan) {
+    const int len = juce::jmin(maxSpan, numSamples - offset);
+    const int pos = writePos + offset;
+
+    // Every channel reads before any writes (ping-pong crosses them)
+    for (int ch = 0; ch < numChannels; ++ch) {
+      readSpan(ch, pos - delayInt, delayed[ch], len);
+
+      if (frac > 0.0f) {
+        readSpan(ch, pos - delayInt - 1, older, len);
+        juce::FloatVectorOperations::subtract(older, delayed[ch], len);
+        juce::FloatVectorOperations::addWithMultiply(delayed[ch], older, frac,
+                                                     len);
+      }
+
+      filterFeedback(ch, delayed[ch], feedbackOut[ch], feedback, offset, len);
+    }
+
+    writeBack(channels, feedbackOut, numChannels, offset, len);
+
+    for (int ch = 0; ch < numChannels; ++ch) {
+      auto *dest = channels[ch] + offset;
+
+      if (wetOnly && mix.isConstant())
+        juce::FloatVectorOperations::copyWithMultiply(dest, delayed[ch],
+                                                      mix.value, len);
+      else if (wetOnly)
+        juce::FloatVectorOperations::multiply(dest, delayed[ch],
+                                              mix.values + offset, len);
+      else if (mix.isConstant())
+        juce::FloatVectorOperations::addWithMultiply(dest, delayed[ch],
+                                                     mix.value, len);
+      else
+        juce::FloatVectorOperations::addWithMultiply(
+            dest, delayed[ch], mix.values + offset, len);
+    }
+  }
+
+  return true;
+}
+
+bool DelayEngine::processRamping(float *const *channels, int numChannels,
+                                 int numSamples, const float *delaySamples,
+                                 const ParameterRamp &feedback,
+                                 const ParameterRamp &mix) {
+  auto *echo = scratch->allocate(numChannels);
+  auto *back = scratch->allocate(numChannels);
+  if (echo == nullptr || back == nullptr)
+    return false;
+
+  const bool crossChannels = pingPong && numChannels > 1;
+  const float inputScale = 1.0f / (float)numChannels;
+
+  for (int i = 0; i < numSamples; ++i) {
+    // Whole and fractional parts kept apart: as one float position the
+    // fraction would lose most of its bits to the ring index
+    const int delayInt = (int)delaySamples[i];
+    const float frac = delaySamples[i] - (float)delayInt;
+    const int readPos = writePos + i - delayInt;
+    const float fb = feedback.isConstant() ? feedback.value
+                                           : feedback.values[i];
+    const float wet = mix.isConstant() ? mix.value : mix.values[i];
+
+    for (int ch = 0; ch < numChannels; ++ch) {
+      echo[ch] = readInterpolated(ch, readPos, frac);
+      auto &z = toneState[(size_t)ch];
+      z += toneCoeff * (echo[ch] - z);
+      back[ch] = fb * z;
+    }
+
+    const int w = (writePos + i) & ringMask;
+    if (crossChannels) {
+      float input = 0.0f;
+      for (int ch = 0; ch < numChannels; ++ch)
+        input += channels[ch][i];
+
+      for (int ch = 0; ch < numChannels; ++ch)
+        ringChannels[ch][w] = back[(ch + numChannels - 1) % numChannels];
+      ringChannels[0][w] += input * inputScale;
+    } else {
+      for (int ch = 0; ch < numChannels; ++ch)
+        ringChannels[ch][w] = channels[ch][i] + back[ch];
+    }
+
+    const float dry = wetOnly ? 0.0f : 1.0f;
+    for (int ch = 0; ch < numChannels; ++ch)
+      channels[ch][i] = dry * channels[ch][i] + wet * echo[ch];
+  }
+
+  return true;
+}
+
+void DelayEngine::readSpan(int ch, int start, float *dest,
+                           int numSamples) const {
+  // Masking wraps negative starts too (two's complement)
+  const int first = start & ringMask;
+  const int head = juce::jmin(numSamples, ringSize - first);
+
+  juce::FloatVectorOperations::copy(dest, ringChannels[ch] + first, head);
+  juce::FloatVectorOperations::copy(dest + head, ringChannels[ch],
+                                    numSamples - head);
+}
+
+void DelayEngine::writeSpan(int ch, int start, const float *src,
+                            int numSamples) {
+  const int first = start & ringMask;
+  const int head = juce::jmin(numSamples, ringSize - first);
+
+  juce::FloatVectorOperations::copy(ringChannels[ch] + first, src, head);
+  juce::FloatVectorOperations::copy(ringChannels[ch], src + head,
+                                    numSamples - head);
+}
+
+float DelayEngine::readInterpolated(int ch, int position, float frac) const {
+  // Same blend as the spans: towards the older sample by frac
+  const float newer = ringChannels[ch][position & ringMask];
+  const float older = ringChannels[ch][(position - 1) & ringMask];
+  return newer + frac * (older - newer);
+}
+
+void DelayEngine::filterFeedback(int ch, const float *delayed, float *dest,
+                                 const ParameterRamp &feedback, int offset,
+                                 int numSamples) {
+  // Recursive, so a plain loop either way
+  float z = toneState[(size_t)ch];
+  const float coeff = toneCoeff;
+
+  if (feedback.isConstant()) {
+    const float fb = feedback.value;
+    for (int i = 0; i < numSamples; ++i) {
+      z += coeff * (delayed[i] - z);
+      dest[i] = fb * z;
+    }
+  } else {
+    const float *fb = feedback.values + offset;
+    for (int i = 0; i < numSamples; ++i) {
+      z += coeff * (delayed[i] - z);
+      dest[i] = fb[i] * z;
+    }
+  }
+
+  toneState[(size_t)ch] = z;
+}
+
+void DelayEngine::writeBack(float *const *channels,
+                            float *const *feedbackOut, int numChannels,
+                            int offset, int numSamples) {
+  const int pos = writePos + offset;
+
+  if (!pingPong || numChannels < 2) {
+    for (int ch = 0; ch < numChannels; ++ch) {
+      juce::FloatVectorOperations::add(feedbackOut[ch], channels[ch] + offset,
+                                       numSamples);
+      writeSpan(ch, pos, feedbackOut[ch], numSamples);
+    }
+    return;
+  }
+
+  // Ping-pong: each echo moves one channel round...
+  for (int ch = 1; ch < numChannels; ++ch)
+    writeSpan(ch, pos, feedbackOut[ch - 1], numSamples);
+
+  // ...and the input, summed to mono, only goes in at the first
+  auto *wrapped = feedbackOut[numChannels - 1];
+  const float inputScale = 1.0f / (float)numChannels;
+  for (int ch = 0; ch < numChannels; ++ch)
+    juce::FloatVectorOperations::addWithMultiply(
+        wrapped, channels[ch] + offset, inputScale, numSamples);
+  writeSpan(0, pos, wrapped, numSamples);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "ParameterRamp.h"
+#include "ScratchArena.h"
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Feedback delay with its own ring buffer per channel.
+    While the delay time holds still the block is processed in spans no
+    longer than the delay, so every read is already written and each span is
+    a handful of vector copies; only a moving time falls back to per-sample
+    interpolated reads.
+
+    Options: tempo sync (note divisions of the host BPM), ping-pong (each
+    channel's echo feeds the next one round) and a one-pole lowpass in the
+    feedback path, so repeats darken as they decay.
+
+    The ring memory is only allocated once the mix is first turned up: the
+    audio thread asks the message thread for it and passes the signal
+    through dry until it is there (as a send, it outputs silence). After
+    that prepare() re-sizes it up front.
+*/
+class DelayEngine : private juce::AsyncUpdater {
+public:
+  static constexpr float maxDelayTime = 2.0f; // Seconds
+
+  DelayEngine() = default;
+  ~DelayEngine() override;
+
+  // Choice names for the sync divisions, in index order
+  static juce::StringArray getDivisionNames();
+
+  void prepare(const juce::dsp::ProcessSpec &spec);
+  void reset();
+  void setScratchArena(ScratchArena *arena) { scratch = arena; }
+
+  // timeSeconds is only used while sync is off
+  void setParameters(float timeSeconds, float feedback, float mix);
+  void setTempoSync(bool enabled, int division, double bpm);
+  void setPingPong(bool enabled) { pingPong = enabled; }
+  // 0 = dark (500 Hz), 1 = open (20 kHz)
+  void setTone(float newTone);
+  // As a send: outputs only the echoes, scaled by the mix
+  void setWetOnly(bool enabled) { wetOnly = enabled; }
+
+  void process(juce::AudioBuffer<float> &buffer);
+
+  // Mix up, or on its way down
+  bool isActive() const {
+    return mixParam.isSmoothing() || mixParam.getTargetValue() > 0.0f;
+  }
+  // While inactive: only writes the input into the ring (no feedback, no
+  // output), so turning the mix back up starts from warm echoes
+  void keepAlive(const juce::AudioBuffer<float> &buffer);
+
+  bool isAllocated() const { return allocated.load(); }
+
+  // How long the output can stay quiet before an echo still comes out.
+  // The whole ring, as a longer delay time could still reach any of it.
+  int getTailSamples() const;
+
+  // Until the repeats fall below -100 dB, for the host's tail length
+  static double getTailSeconds(double delaySeconds, double feedback);
+  // Length of one synced repeat
+  static double getSyncedSeconds(int division, double bpm);
+
+private:
+  void handleAsyncUpdate() override;
+  void allocate();
+  void clearRing();
+  void updateTimeTarget();
+  void updateToneCoeff();
+
+  // Both false, with nothing touched, if the scratch arena is full
+  bool processSpans(float *const *channels, int numChannels, int numSamples,
+                    float delaySamples, const ParameterRamp &feedback,
+                    const ParameterRamp &mix);
+  bool processRamping(float *const *channels, int numChannels,
+                      int numSamples, const float *delaySamples,
+                      const ParameterRamp &feedback, const ParameterRamp &mix);
+
+  // Ring access, wrapping through the power-of-two mask
+  void readSpan(int ch, int start, float *dest, int numSamples) const;
+  void writeSpan(int ch, int start, const float *src, int numSamples);
+  // `position` is the newer of the two samples blended
+  float readInterpolated(int ch, int position, float frac) const;
+
+  // One-pole lowpass on a channel's feedback, then scaled by the feedback
+  void filterFeedback(int ch, const float *delayed, float *dest,
+                      const ParameterRamp &feedback, int offset,
+                      int numSamples);
+  // What each channel writes back: its own filtered echo, or with ping-pong
+  // the previous channel's (and only the first channel takes the input)
+  void writeBack(float *const *channels, float *const *feedbackOut,
+                 int numChannels, int offset, int numSamples);
+
+  ScratchArena *scratch = nullptr;
+
+  juce::LinearSmoothedValue<float> timeParam; // Seconds
+  juce::LinearSmoothedValue<float> feedbackParam;
+  juce::LinearSmoothedValue<float> mixParam;
+
+  float freeTime = 0.5f;
+  bool syncEnabled = false;
+  int syncDivision = 2;
+  double hostBpm = 120.0;
+  bool pingPong = false;
+  float tone = 1.0f;
+  float toneCoeff = 1.0f; // One-pole coefficient, 1 = unfiltered
+  bool wetOnly = false;
+
+  // Ring memory. `allocated` publishes it to the audio thread; the message
+  // thread doesn't touch it again until the next prepare().
+  juce::AudioBuffer<float> ring;
+  float *const *ringChannels = nullptr;
+  std::atomic<bool> allocated{false};
+  int ringMask = 0;
+  int writePos = 0;
+  std::vector<float> toneState;
+
+  double sampleRate = 44100.0;
+  int numPreparedChannels = 0;
+  int ringSize = 0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DelayEngine)
+};
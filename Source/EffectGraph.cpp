@@ -0,0 +1,84 @@
+#include "EffectGraph.h"
+
+juce::StringArray EffectGraph::getPresetNames() {
+  return {"Standard", "Ethereal", "Chaos", "Reverse", "Sends", "Clean Sends"};
+}
+
+EffectGraph::Topology EffectGraph::getPreset(int index) {
+  using E = Effect;
+  Topology t;
+
+  // Standard: Dist -> Bite -> Delay -> Reverb
+  // Ethereal: Reverb -> Delay -> Dist -> Bite
+  // Chaos: Delay -> Dist -> Bite -> Reverb
+  // Reverse: Reverb -> Delay -> Bite -> Dist
+  // Sends: Dist -> Bite, with Delay and Reverb as sends off the end
+  // Clean Sends: Delay and Reverb sent from the clean signal, under
+  // Dist -> Bite
+  switch (index) {
+  default:
+  case 0:
+    t.order = {E::Distortion, E::TransientShaper, E::Delay, E::Reverb};
+    break;
+  case 1:
+    t.order = {E::Reverb, E::Delay, E::Distortion, E::TransientShaper};
+    break;
+  case 2:
+    t.order = {E::Delay, E::Distortion, E::TransientShaper, E::Reverb};
+    break;
+  case 3:
+    t.order = {E::Reverb, E::Delay, E::TransientShaper, E::Distortion};
+    break;
+  case 4:
+    t.order = {E::Distortion, E::TransientShaper, E::Delay, E::Reverb};
+    t.send[(size_t)E::Delay] = t.send[(size_t)E::Reverb] = true;
+    break;
+  case 5:
+    t.order = {E::Delay, E::Reverb, E::Distortion, E::TransientShaper};
+    t.send[(size_t)E::Delay] = t.send[(size_t)E::Reverb] = true;
+    break;
+  }
+
+  return t;
+}
+
+EffectGraph::EffectGraph() { compile(topology); }
+
+void EffectGraph::prepare(int newNumChannels, int maximumBlockSize) {
+  numChannels = newNumChannels;
+  branches.setSize(maxBranches * numChannels, maximumBlockSize);
+  branches.clear();
+  branchChannels = branches.getArrayOfWritePointers();
+}
+
+void EffectGraph::compile(const Topology &newTopology) {
+  topology = newTopology;
+  send.fill(false);
+  numSteps = 0;
+  int numBranches = 0;
+
+  for (auto effect : topology.order) {
+    // Anything that can't be a send, or one send too many, stays serial
+    const bool isBranch = topology.send[(size_t)effect] && canSend(effect) &&
+                          numBranches < maxBranches;
+
+    if (isBranch) {
+      send[(size_t)effect] = true;
+      steps[(size_t)numSteps++] = {Step::Op::Tap, effect, numBranches};
+      steps[(size_t)numSteps++] = {Step::Op::Process, effect, numBranches};
+      ++numBranches;
+    } else {
+      steps[(size_t)numSteps++] = {Step::Op::Process, effect, -1};
+    }
+  }
+
+  for (int b = 0; b < numBranches; ++b)
+    steps[(size_t)numSteps++] = {Step::Op::Sum, Effect::Distortion, b};
+}
+
+juce::AudioBuffer<float> EffectGraph::getBranch(int branch, int numSamples) {
+  jassert(numSamples <= branches.getNumSamples());
+  return juce::AudioBuffer<float>(
+      branchChannels + branch * numChannels, numChannels,
+      juce::jmin(numSamples, branches.getNumSamples()));
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    How the effects are wired: a serial chain, with delay and reverb
+    optionally pulled out as parallel sends. A send taps the chain where it
+    sits in the order, runs wet only (its mix becomes the send level) and is
+    summed back in at the end, so it never reprocesses another effect's wet
+    signal.
+
+    compile() flattens a topology into a list of steps with fixed branch
+    buffers. It runs only when the topology changes and never allocates, so
+    the audio thread may call it. A branch's steps don't touch the main
+    chain until its sum, which is what would let one run on another thread.
+*/
+class EffectGraph {
+public:
+  enum class Effect { Distortion, TransientShaper, Delay, Reverb };
+  static constexpr int numEffects = 4;
+  static constexpr int maxBranches = 2; // Only delay and reverb can send
+
+  struct Topology {
+    std::array<Effect, numEffects> order = {
+        Effect::Distortion, Effect::TransientShaper, Effect::Delay,
+        Effect::Reverb};
+    std::array<bool, numEffects> send{}; // Indexed by Effect
+
+    bool operator==(const Topology &other) const {
+      return order == other.order && send == other.send;
+    }
+    bool operator!=(const Topology &other) const { return !(*this == other); }
+  };
+
+  struct Step {
+    enum class Op {
+      Tap,     // Copy the chain into the branch
+      Process, // Run the effect on the chain (branch < 0) or the branch
+      Sum      // Add the branch back into the chain
+    };
+
+    Op op = Op::Process;
+    Effect effect = Effect::Distortion;
+    int branch = -1;
+  };
+
+  // The CHAIN_ORDER choices, in index order
+  static juce::StringArray getPresetNames();
+  static Topology getPreset(int index);
+
+  static bool canSend(Effect effect) {
+    return effect == Effect::Delay || effect == Effect::Reverb;
+  }
+
+  EffectGraph();
+
+  // Message thread: sizes the branch buffers
+  void prepare(int numChannels, int maximumBlockSize);
+
+  void compile(const Topology &newTopology);
+  const Topology &getTopology() const { return topology; }
+  bool isSend(Effect effect) const { return send[(size_t)effect]; }
+
+  const Step *begin() const { return steps.data(); }
+  const Step *end() const { return steps.data() + numSteps; }
+
+  // The first numSamples of a branch buffer (refers to it, no copy). Safe
+  // to call from the thread running that branch.
+  juce::AudioBuffer<float> getBranch(int branch, int numSamples);
+
+private:
+  // A tap and a process per send, a process per serial effect, a sum per
+  // send
+  static constexpr int maxSteps = numEffects + 2 * maxBranches;
+
+  Topology topology;
+  std::array<bool, numEffects> send{}; // As compiled
+  std::array<Step, maxSteps> steps{};
+  int numSteps = 0;
+
+  // maxBranches groups of numChannels channels. Handed out through the raw
+  // pointers, never the AudioBuffer (its clear flag is not thread safe).
+  juce::AudioBuffer<float> branches;
+  float *const *branchChannels = nullptr;
+  int numChannels = 0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EffectGraph)
+};
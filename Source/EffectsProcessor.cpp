@@ -1,11 +1,42 @@
 #include "EffectsProcessor.h"
 
-EffectsProcessor::EffectsProcessor() {
-  // Initialize Waveshaper with tanh transfer function
-  distortion.functionToUse = [](float x) { return std::tanh(x); };
+// Samples the distortion kernel works on at a time (fits on the stack)
+static constexpr int shaperChunk = 256;
+
+// (7,6) Pade approximant of tanh, within 1.01e-4 of tanh for |v| <= 5 (the
+// error grows with |v|, so the worst case is at the clip). No branches or
+// library calls, so loops using it vectorise 4/8 wide.
+static inline float padeTanh(float v) {
+  const float v2 = v * v;
+  const float num = v * (135135.0f + v2 * (17325.0f + v2 * (378.0f + v2)));
+  const float den = 135135.0f + v2 * (62370.0f + v2 * (3150.0f + v2 * 28.0f));
+  return num / den;
+}
+
+// tanh drive for one channel: x = clip(data * gain, +-5), then the dry/wet
+// blend. Steady drive and mix (the usual case)...
+static void waveshape(float *data, float gain, float mix, int numSamples) {
+  alignas(64) float x[shaperChunk];
+  juce::FloatVectorOperations::copyWithMultiply(x, data, gain, numSamples);
+  juce::FloatVectorOperations::clip(x, x, -5.0f, 5.0f, numSamples);
+
+  for (int i = 0; i < numSamples; ++i)
+    data[i] += mix * (padeTanh(x[i]) - data[i]);
+}
+
+// ...and per-sample drive and mix while either is moving
+static void waveshape(float *data, const float *gain, const float *mix,
+                      int numSamples) {
+  alignas(64) float x[shaperChunk];
+  juce::FloatVectorOperations::multiply(x, data, gain, numSamples);
+  juce::FloatVectorOperations::clip(x, x, -5.0f, 5.0f, numSamples);
 
-  // Delay setup
-  delayLine.setMaximumDelayInSamples(44100 * 2);
+  for (int i = 0; i < numSamples; ++i)
+    data[i] += mix[i] * (padeTanh(x[i]) - data[i]);
+}
+
+EffectsProcessor::EffectsProcessor() {
+  // The delay allocates its memory itself, once it's first turned up
 }
 
 EffectsProcessor::~EffectsProcessor() {}
@@ -14,42 +45,49 @@ void EffectsProcessor::prepare(juce::dsp::ProcessSpec &spec) {
   currentSampleRate = spec.sampleRate;
 
   // Prepare Distortion
-  distortion.prepare(spec);
   distDriveParam.reset(currentSampleRate, 0.05); // 50ms ramp
   distMixParam.reset(currentSampleRate, 0.05);
 
-  // Prepare Transient Shaper
-  transientShaper.prepare(spec);
+  // Oversamplers for both nonlinear stages, every quality built up front
+  distOversampler.prepare(spec);
+  biteOversampler.prepare(spec);
+
+  // Prepare Transient Shaper, its gains delayed by up to the up filter's
+  // latency (half the oversampler's, the two filters being alike)
+  transientShaper.prepare(spec,
+                          (biteOversampler.getMaxLatencySamples() + 1) / 2);
 
   // Prepare Delay
-  delayLine.prepare(spec);
-  // Important: Set correct max delay based on sample rate
-  delayLine.setMaximumDelayInSamples(
-      static_cast<int>(spec.sampleRate * maxDelayTime));
-  delayLine.reset();
-
-  delayTimeParam.reset(currentSampleRate,
-                       0.5); // Slower ramp for delay time to avoid pitch jumps?
-                             // Actually fast ramp + interpolation is better for
-                             // "swoop". 0.05 is standard.
-  delayTimeParam.reset(currentSampleRate, 0.05);
-  delayFeedbackParam.reset(currentSampleRate, 0.05);
-  delayMixParam.reset(currentSampleRate, 0.05);
-
-  // Prepare Reverb
+  delay.prepare(spec);
+
+  // Prepare Reverb (both kinds)
   reverb.prepare(spec);
-  reverb.reset();
-  reverbMixParam.reset(currentSampleRate, 0.05);
+  convolution.prepare(spec);
 
-  // Reserve ramp buffer
-  rampBuffer.reserve(spec.maximumBlockSize);
+  // Branch buffers for the parallel sends
+  graph.prepare((int)spec.numChannels, (int)spec.maximumBlockSize);
+
+  // Nothing is playing yet, so a pending wiring needs no fade
+  routingGain.reset(currentSampleRate, 0.005);
+  if (topologyPending)
+    applyTopology(pendingTopology);
+  routingGain.setCurrentAndTargetValue(1.0f);
+
+  if (scratch != nullptr)
+    for (auto &arena : branchArenas)
+      arena.prepare(scratch->getCapacity());
 }
 
 void EffectsProcessor::reset() {
-  distortion.reset();
+  distOversampler.reset();
   transientShaper.reset();
-  delayLine.reset();
+  biteOversampler.reset();
+  delay.reset();
   reverb.reset();
+  convolution.reset();
+
+  for (auto &gate : gates)
+    gate.reset();
 
   // Reset smoothers to target ?? No, usually just keep current.
 }
@@ -63,31 +101,224 @@ void EffectsProcessor::updateParameters(float distDrive, float distMix,
   distMixParam.setTargetValue(distMix);
   transientShaper.setAmount(biteAmount); // Shaper handles its own smoothing
 
-  delayTimeParam.setTargetValue(delayTime);
-  delayFeedbackParam.setTargetValue(delayFeedback);
-  delayMixParam.setTargetValue(delayMix);
+  delay.setParameters(delayTime, delayFeedback, delayMix);
 
-  // Map Reverb params
-  reverbParams.roomSize = reverbSize;
-  reverbParams.damping = reverbDamping;
+  reverb.setParameters(reverbSize, reverbDamping, reverbMix);
+  convolution.setParameters(reverbSize, reverbDamping, reverbMix);
+}
 
-  // Revert to internal mixing to ensure Dry/Wet balance works without temp
-  // buffer
-  reverbParams.wetLevel = reverbMix;
-  reverbParams.dryLevel = 1.0f - reverbMix;
+void EffectsProcessor::setDelayOptions(bool sync, int division, double bpm,
+                                       bool pingPong, float tone) {
+  delay.setTempoSync(sync, division, bpm);
+  delay.setPingPong(pingPong);
+  delay.setTone(tone);
+}
 
-  reverbParams.width = 1.0f;
-  reverbParams.freezeMode = 0.0f;
+void EffectsProcessor::setConvolutionReverb(bool enabled) {
+  if (enabled == useConvolution)
+    return;
+
+  // The one taking over starts from silence rather than from whatever it
+  // held when it was last switched away from. The convolution reverb only
+  // allocates and starts its threads once it is first chosen.
+  useConvolution = enabled;
+  if (enabled) {
+    convolution.requestStart();
+    convolution.reset();
+  } else {
+    reverb.reset();
+  }
+  gates[(size_t)EffectType::Reverb].reset();
+}
 
-  reverb.setParameters(reverbParams);
-  reverbMixParam.setTargetValue(
-      reverbMix); // Keep for the on/off check in processReverb
+void EffectsProcessor::setBiteLookahead(bool enabled) {
+  transientShaper.setLookahead(enabled);
+}
+
+void EffectsProcessor::setOversampling(int order,
+                                       Oversampler::Filter filter) {
+  if (order == distOversampler.getOrder() &&
+      order == biteOversampler.getOrder() && filter == oversamplingFilter)
+    return;
+
+  oversamplingFilter = filter;
+  distOversampler.setQuality(order, filter);
+  biteOversampler.setQuality(order, filter);
+}
+
+void EffectsProcessor::setTopology(const EffectGraph::Topology &topology) {
+  // Switched back before the fade-out finished: fade straight back in
+  if (topology == graph.getTopology()) {
+    topologyPending = false;
+    routingGain.setTargetValue(1.0f);
+    return;
+  }
+
+  if (topologyPending && topology == pendingTopology)
+    return;
+
+  pendingTopology = topology;
+  topologyPending = true;
+  routingGain.setTargetValue(0.0f);
+}
+
+void EffectsProcessor::applyTopology(const EffectGraph::Topology &topology) {
+  topologyPending = false;
+  graph.compile(topology);
+
+  // Sends come back on top of the dry chain, so they add their wet only
+  delay.setWetOnly(graph.isSend(EffectType::Delay));
+  reverb.setWetOnly(graph.isSend(EffectType::Reverb));
+  convolution.setWetOnly(graph.isSend(EffectType::Reverb));
 }
 
 void EffectsProcessor::process(juce::AudioBuffer<float> &buffer) {
   juce::ScopedNoDenormals noDenormals;
 
-  for (auto effect : chainOrder) {
+  const int numSamples = buffer.getNumSamples();
+  const int numChannels = buffer.getNumChannels();
+  bool silent = SilenceGate::isSilent(buffer);
+
+  // Faded out under the old wiring: the new one takes over from here
+  if (topologyPending && routingGain.getCurrentValue() == 0.0f) {
+    applyTopology(pendingTopology);
+    routingGain.setTargetValue(1.0f);
+  }
+
+  // Serial until the workers are up, which only a send asks for
+  const bool wantParallel =
+      workers != nullptr && parallelSends &&
+      (graph.isSend(EffectType::Delay) || graph.isSend(EffectType::Reverb)) &&
+      numSamples >= minParallelBlock && branchArenas[0].getCapacity() > 0;
+  if (wantParallel && !workers->hasWorkers())
+    workers->requestWorkers();
+  const bool parallel = wantParallel && workers->hasWorkers();
+  numBranchJobs = 0;
+  numStarted = 0;
+
+  for (const auto &step : graph) {
+    using Op = EffectGraph::Step::Op;
+
+    if (step.branch < 0) {
+      // Queued sends go to the workers while the chain carries on here
+      if (parallel)
+        startBranchJobs(false);
+      runSlot(step.effect, buffer, silent);
+      continue;
+    }
+
+    const auto b = (size_t)step.branch;
+    auto branch = graph.getBranch(step.branch, numSamples);
+    const int branchSamples = branch.getNumSamples();
+    const int branchChannels =
+        juce::jmin(numChannels, branch.getNumChannels());
+
+    switch (step.op) {
+    case Op::Tap:
+      for (int ch = 0; ch < branchChannels; ++ch)
+        branch.copyFrom(ch, 0, buffer, ch, 0, branchSamples);
+      branchSilent[b] = silent;
+      break;
+    case Op::Process: {
+      auto &job = branchJobs[(size_t)numBranchJobs++];
+      job = {step.effect, step.branch, numSamples};
+      if (!parallel)
+        runBranch(job);
+      break;
+    }
+    case Op::Sum:
+      if (parallel)
+        startBranchJobs(true);
+      if (!branchLive[b])
+        break;
+      for (int ch = 0; ch < branchChannels; ++ch)
+        buffer.addFrom(ch, 0, branch, ch, 0, branchSamples);
+      silent = false;
+      break;
+    }
+  }
+
+  jassert(!sendBatch.isRunning());
+
+  if (routingGain.isSmoothing() || routingGain.getCurrentValue() < 1.0f) {
+    const float startGain = routingGain.getCurrentValue();
+    buffer.applyGainRamp(0, numSamples, startGain,
+                         routingGain.skip(numSamples));
+  }
+}
+
+void EffectsProcessor::runBranch(const BranchJob &job) {
+  const auto b = (size_t)job.branch;
+  auto branch = graph.getBranch(job.branch, job.numSamples);
+  branchLive[b] =
+      runSlot(job.effect, branch, branchSilent[b]) && !branchSilent[b];
+}
+
+void EffectsProcessor::startBranchJobs(bool joinNow) {
+  const int queued = numBranchJobs - numStarted;
+
+  if (queued > 0) {
+    // Another batch may still be out: one at a time
+    workers->join(sendBatch);
+
+    if (joinNow && queued == 1) {
+      // Nothing to overlap it with
+      runBranch(branchJobs[(size_t)numStarted]);
+    } else {
+      batchFirst = numStarted;
+      workers->start(sendBatch, &EffectsProcessor::runBranchJob, this,
+                     queued);
+    }
+    numStarted = numBranchJobs;
+  }
+
+  if (joinNow)
+    workers->join(sendBatch);
+}
+
+void EffectsProcessor::runBranchJob(void *context, int index) {
+  auto &self = *static_cast<EffectsProcessor *>(context);
+  const auto &job = self.branchJobs[(size_t)(self.batchFirst + index)];
+
+  auto &arena = self.branchArenas[(size_t)job.branch];
+  arena.reset();
+  self.setSlotArena(job.effect, &arena);
+  self.runBranch(job);
+  self.setSlotArena(job.effect, self.scratch);
+}
+
+void EffectsProcessor::setSlotArena(EffectType effect, ScratchArena *arena) {
+  switch (effect) {
+  case EffectType::Delay:
+    delay.setScratchArena(arena);
+    break;
+  case EffectType::Reverb:
+    reverb.setScratchArena(arena);
+    convolution.setScratchArena(arena);
+    break;
+  default:
+    // Only delay and reverb can send
+    jassertfalse;
+    break;
+  }
+}
+
+bool EffectsProcessor::runSlot(EffectType effect,
+                               juce::AudioBuffer<float> &buffer,
+                               bool &silent) {
+  // Each stage's output is the next one's input, so one check per stage
+  auto &gate = gates[(size_t)effect];
+  const bool inputSilent = silent;
+  if (gate.canSkip(inputSilent, getTailSamples(effect))) {
+    if (gate.fallAsleep())
+      clearFeedback(effect);
+    return false;
+  }
+
+  const bool active = isSlotActive(effect);
+  if (!active) {
+    bypassSlot(effect, buffer);
+  } else {
     switch (effect) {
     case EffectType::Distortion:
       processDistortion(buffer);
@@ -96,88 +327,199 @@ void EffectsProcessor::process(juce::AudioBuffer<float> &buffer) {
       processTransientShaper(buffer);
       break;
     case EffectType::Delay:
-      processDelay(buffer);
+      delay.process(buffer);
       break;
     case EffectType::Reverb:
-      processReverb(buffer);
+      if (useConvolution)
+        convolution.process(buffer);
+      else
+        reverb.process(buffer);
       break;
     }
   }
-}
-
-void EffectsProcessor::processDistortion(juce::AudioBuffer<float> &buffer) {
-  auto totalNumInputChannels = buffer.getNumChannels();
-  auto numSamples = buffer.getNumSamples();
-
-  auto *ch0 = buffer.getWritePointer(0);
-  auto *ch1 = (totalNumInputChannels > 1) ? buffer.getWritePointer(1) : nullptr;
 
-  for (int i = 0; i < numSamples; ++i) {
-    float drive = distDriveParam.getNextValue();
-    float mix = distMixParam.getNextValue();
+  silent = SilenceGate::isSilent(buffer);
+  gate.update(inputSilent, silent, buffer.getNumSamples());
+  return active;
+}
 
-    float gain = 1.0f + (drive * 49.0f);
+void EffectsProcessor::clearFeedback(EffectType effect) {
+  // Whatever is still circulating was too quiet to hear at the current mix,
+  // but could be turned up later: drop it instead. Convolution only ever
+  // holds its input, which the gate has already seen go silent.
+  switch (effect) {
+  case EffectType::Delay:
+    delay.reset();
+    break;
+  case EffectType::Reverb:
+    if (!useConvolution)
+      reverb.reset();
+    break;
+  default:
+    break;
+  }
+}
 
-    float dry0 = ch0[i];
-    float wet0 = std::tanh(dry0 * gain);
-    ch0[i] = (dry0 * (1.0f - mix)) + (wet0 * mix);
+bool EffectsProcessor::isSlotActive(EffectType effect) const {
+  switch (effect) {
+  case EffectType::Distortion:
+    return distMixParam.isSmoothing() || distMixParam.getTargetValue() > 0.0f;
+  case EffectType::TransientShaper:
+    return transientShaper.isActive();
+  case EffectType::Delay:
+    return delay.isActive();
+  case EffectType::Reverb:
+    return useConvolution ? convolution.isActive() : reverb.isActive();
+  }
+  return true;
+}
 
-    if (ch1) {
-      float dry1 = ch1[i];
-      float wet1 = std::tanh(dry1 * gain);
-      ch1[i] = (dry1 * (1.0f - mix)) + (wet1 * mix);
-    }
+void EffectsProcessor::bypassSlot(EffectType effect,
+                                  juce::AudioBuffer<float> &buffer) {
+  // Still called through the fade-out after a switch, when the stage's
+  // own mix is already at zero: the filters alone are all that's left
+  auto unprocessed = [](juce::dsp::AudioBlock<float> &, int) {};
+
+  switch (effect) {
+  case EffectType::Distortion:
+    // Drive lands where it's headed, ready for the mix to come back
+    distDriveParam.skip(buffer.getNumSamples());
+    distOversampler.process(buffer, false, unprocessed);
+    break;
+  case EffectType::TransientShaper:
+    transientShaper.delay(buffer);
+    biteOversampler.process(buffer, false, unprocessed);
+    break;
+  case EffectType::Delay:
+    delay.keepAlive(buffer);
+    break;
+  case EffectType::Reverb:
+    if (useConvolution)
+      convolution.keepAlive(buffer);
+    else
+      reverb.keepAlive(buffer);
+    break;
   }
 }
 
-void EffectsProcessor::processTransientShaper(
-    juce::AudioBuffer<float> &buffer) {
-  transientShaper.process(buffer);
+int EffectsProcessor::getTailSamples(EffectType effect) const {
+  // Distortion and Bite are memoryless apart from the oversampling
+  // filters' latency (and Bite's lookahead)
+  switch (effect) {
+  case EffectType::Distortion:
+    return distOversampler.getLatencySamples();
+  case EffectType::TransientShaper:
+    return biteOversampler.getLatencySamples() +
+           transientShaper.getLatencySamples();
+  case EffectType::Delay:
+    return delay.getTailSamples();
+  case EffectType::Reverb:
+    return useConvolution ? convolution.getTailSamples()
+                          : reverb.getTailSamples();
+  }
+  return 0;
 }
 
-void EffectsProcessor::processDelay(juce::AudioBuffer<float> &buffer) {
-  auto totalNumInputChannels = buffer.getNumChannels();
+void EffectsProcessor::processDistortion(juce::AudioBuffer<float> &buffer) {
   auto numSamples = buffer.getNumSamples();
+  if (numSamples == 0)
+    return;
+
+  jassert(scratch != nullptr);
+  ScratchArena::ScopedRewind rewind(*scratch);
+  auto drive = ParameterRamp::next(distDriveParam, *scratch, numSamples);
+  auto mix = ParameterRamp::next(distMixParam, *scratch, numSamples);
+
+  // Moving: per-sample ramps for the whole block, shared by every channel
+  float *gain = nullptr;
+  float *mixValues = nullptr;
+  if (!drive.isConstant() || !mix.isConstant()) {
+    gain = drive.toBuffer(*scratch, numSamples);
+    mixValues = mix.toBuffer(*scratch, numSamples);
+  }
 
-  auto *ch0 = buffer.getWritePointer(0);
-  auto *ch1 = (totalNumInputChannels > 1) ? buffer.getWritePointer(1) : nullptr;
-
-  for (int i = 0; i < numSamples; ++i) {
-    float time = delayTimeParam.getNextValue();
-    float fdbk = delayFeedbackParam.getNextValue();
-    float mix = delayMixParam.getNextValue();
-
-    float delaySamples = time * (float)currentSampleRate;
-    delaySamples = juce::jlimit(1.0f, (float)(maxDelayTime * currentSampleRate),
-                                delaySamples);
-
-    delayLine.setDelay(delaySamples);
-
-    {
-      float input = ch0[i];
-      float delayed = delayLine.popSample(0, -1.0f);
-      float fbSignal = input + (delayed * fdbk);
-      delayLine.pushSample(0, fbSignal);
-      ch0[i] = input + (delayed * mix);
-    }
-
-    if (ch1) {
-      float input = ch1[i];
-      float delayed = delayLine.popSample(1, -1.0f);
-      float fbSignal = input + (delayed * fdbk);
-      delayLine.pushSample(1, fbSignal);
-      ch1[i] = input + (delayed * mix);
-    }
+  // Drive 0..1 -> gain 1..50. Held at the end values if the arena is full.
+  if (gain == nullptr || mixValues == nullptr) {
+    const float steadyGain = 1.0f + drive.value * 49.0f;
+
+    distOversampler.process(
+        buffer, true, [&](juce::dsp::AudioBlock<float> &block, int) {
+          const int blockSamples = (int)block.getNumSamples();
+
+          for (size_t ch = 0; ch < block.getNumChannels(); ++ch) {
+            auto *data = block.getChannelPointer(ch);
+            for (int start = 0; start < blockSamples; start += shaperChunk)
+              waveshape(data + start, steadyGain, mix.value,
+                        juce::jmin(shaperChunk, blockSamples - start));
+          }
+        });
+    return;
   }
+
+  juce::FloatVectorOperations::multiply(gain, 49.0f, numSamples);
+  juce::FloatVectorOperations::add(gain, 1.0f, numSamples);
+
+  distOversampler.process(
+      buffer, true, [&](juce::dsp::AudioBlock<float> &block, int order) {
+        const int blockSamples = (int)block.getNumSamples();
+
+        alignas(64) float heldGain[shaperChunk];
+        alignas(64) float heldMix[shaperChunk];
+
+        for (int start = 0; start < blockSamples; start += shaperChunk) {
+          const int len = juce::jmin(shaperChunk, blockSamples - start);
+          const float *chunkGain = gain + start;
+          const float *chunkMix = mixValues + start;
+
+          // Oversampled: hold each base-rate ramp value for 2^order samples
+          if (order > 0) {
+            for (int i = 0; i < len; ++i) {
+              heldGain[i] = gain[(start + i) >> order];
+              heldMix[i] = mixValues[(start + i) >> order];
+            }
+            chunkGain = heldGain;
+            chunkMix = heldMix;
+          }
+
+          for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+            waveshape(block.getChannelPointer(ch) + start, chunkGain,
+                      chunkMix, len);
+        }
+      });
 }
 
-void EffectsProcessor::processReverb(juce::AudioBuffer<float> &buffer) {
-  // Use TargetValue because we are using block-based mixing via setParameters,
-  // so the Smoother isn't technically advanced per sample, but Target holds
-  // current setting.
-  if (reverbMixParam.getTargetValue() > 0.0f) {
-    juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
-    reverb.process(context);
+void EffectsProcessor::processTransientShaper(
+    juce::AudioBuffer<float> &buffer) {
+  const int numSamples = buffer.getNumSamples();
+  const int numChannels = buffer.getNumChannels();
+  if (numSamples == 0)
+    return;
+
+  jassert(scratch != nullptr);
+  ScratchArena::ScopedRewind rewind(*scratch);
+  auto **gains = static_cast<float **>(
+      scratch->allocateBytes((size_t)numChannels * sizeof(float *)));
+  for (int ch = 0; gains != nullptr && ch < numChannels; ++ch)
+    gains[ch] = scratch->allocate(numSamples);
+
+  // Arena full: unshaped, through the same delays so the latency holds
+  if (gains == nullptr || scratch->hasOverflowed()) {
+    transientShaper.delay(buffer);
+    biteOversampler.process(buffer, false,
+                            [](juce::dsp::AudioBlock<float> &, int) {});
+    return;
   }
+
+  // Envelopes at the base rate, ahead of the (lookahead-delayed) audio,
+  // then held back as long as the up filter holds back the audio
+  transientShaper.analyse(buffer, gains);
+  transientShaper.setGainDelay((biteOversampler.getLatencySamples() + 1) / 2);
+  transientShaper.delayGains(gains, numChannels, numSamples);
+  transientShaper.delay(buffer);
+
+  // Its gain modulation aliases too, so the gain goes on oversampled
+  biteOversampler.process(
+      buffer, true, [&](juce::dsp::AudioBlock<float> &block, int order) {
+        transientShaper.applyGains(block, gains, order);
+      });
 }
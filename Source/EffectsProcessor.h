@@ -1,11 +1,20 @@
 #pragma once
 
+#include "ConvolutionReverb.h"
+#include "DelayEngine.h"
+#include "EffectGraph.h"
+#include "FdnReverb.h"
+#include "Oversampler.h"
+#include "ParameterRamp.h"
+#include "ScratchArena.h"
+#include "SilenceGate.h"
 #include "TransientShaper.h"
+#include "WorkerPool.h"
 #include <JuceHeader.h>
 
 class EffectsProcessor {
 public:
-  enum class EffectType { Distortion, TransientShaper, Delay, Reverb };
+  using EffectType = EffectGraph::Effect;
 
   EffectsProcessor();
   ~EffectsProcessor();
@@ -13,60 +22,158 @@ public:
   void prepare(juce::dsp::ProcessSpec &spec);
   void process(juce::AudioBuffer<float> &buffer);
   void reset();
-
-  void setChainOrder(const std::array<EffectType, 4> &newOrder) {
-    chainOrder = newOrder;
+  void setScratchArena(ScratchArena *arena) {
+    scratch = arena;
+    transientShaper.setScratchArena(arena);
+    delay.setScratchArena(arena);
+    reverb.setScratchArena(arena);
+    convolution.setScratchArena(arena);
   }
 
-  const std::array<EffectType, 4> &getChainOrder() const { return chainOrder; }
+  // Sends can run on the pool's workers, concurrently with each other and
+  // with the rest of the chain, in blocks of at least minParallelBlock
+  // samples. Below that the wake-up and join cost more than they save.
+  // The workers are only asked for once a send actually runs in parallel.
+  // The convolution reverb's tail runs on the same pool.
+  static constexpr int minParallelBlock = 256;
+  void setWorkerPool(WorkerPool *pool) {
+    workers = pool;
+    convolution.setWorkerPool(pool);
+  }
+  void setParallelSends(bool enabled) { parallelSends = enabled; }
+
+  // Re-compiles the graph only when the wiring actually changes. The
+  // output fades out first and back in on the new wiring, as stages
+  // moving between insert and send switch their dry signal on or off.
+  void setTopology(const EffectGraph::Topology &topology);
+  const EffectGraph::Topology &getTopology() const {
+    return graph.getTopology();
+  }
 
   void updateParameters(float distDrive, float distMix, float delayTime,
                         float delayFeedback, float delayMix, float reverbSize,
                         float reverbDamping, float reverbMix, float biteAmount);
 
+  // Delay options: tempo sync to the host BPM (division indexes
+  // DelayEngine::getDivisionNames), ping-pong and feedback tone
+  void setDelayOptions(bool sync, int division, double bpm, bool pingPong,
+                       float tone);
+
+  // Reverb density vs CPU: 8 or 16 delay lines
+  void setReverbLines(int lines) { reverb.setNumLines(lines); }
+  // The reverb slot runs the convolution reverb instead of the FDN
+  void setConvolutionReverb(bool enabled);
+  // Message thread: an IR file for the convolution reverb, prepared in the
+  // background. Cleared, it goes back to the generated cave.
+  void loadImpulseResponse(const juce::File &file) {
+    convolution.loadImpulseResponse(file);
+  }
+  void clearImpulseResponse() { convolution.clearImpulseResponse(); }
+  double getConvolutionTailSeconds() const {
+    return convolution.getTailSeconds();
+  }
+
+  // Oversampling for the nonlinear stages (Distortion and Bite).
+  // order 0 is off, 1..3 is 2x..8x
+  void setOversampling(int order, Oversampler::Filter filter);
+  // Bite's lookahead: the audio runs 2 ms behind its envelopes
+  void setBiteLookahead(bool enabled);
+
+  // Both wrapped stages run in series, so their latencies add up
+  int getLatencySamples() const {
+    return distOversampler.getLatencySamples() +
+           biteOversampler.getLatencySamples() +
+           transientShaper.getLatencySamples();
+  }
+
 private:
-  // Helper for smoothing
-  void generateRamp(juce::LinearSmoothedValue<float> &smoother, int numSamples);
-  std::vector<float> rampBuffer;
+  // Ramps for the smoothers (see ParameterRamp) live here
+  ScratchArena *scratch = nullptr;
 
   // --- Distortion ---
-  // Use Waveshaper for standard tanh distortion (Josh Hodge style)
+  // tanh waveshaper (see waveshape() in the .cpp)
   juce::LinearSmoothedValue<float> distDriveParam;
   juce::LinearSmoothedValue<float> distMixParam;
-  juce::dsp::WaveShaper<float> distortion;
+  Oversampler distOversampler;
 
   // --- Transient Shaper ---
   TransientShaper transientShaper;
+  Oversampler biteOversampler;
 
   // --- Delay ---
-  juce::LinearSmoothedValue<float> delayTimeParam;
-  juce::LinearSmoothedValue<float> delayFeedbackParam;
-  juce::LinearSmoothedValue<float> delayMixParam;
-
-  // Choose Lagrange for better pitch shifting/modulation support, or Linear for
-  // efficiency. Using Linear for standard echo.
-  juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear>
-      delayLine;
-  static constexpr float maxDelayTime = 2.0f;
-  std::vector<float>
-      delayFeedbackBuffer; // To store feedback values per channel
+  DelayEngine delay;
 
   // --- Reverb ---
-  juce::dsp::Reverb reverb;
-  juce::dsp::Reverb::Parameters reverbParams;
-  juce::LinearSmoothedValue<float> reverbMixParam;
+  FdnReverb reverb;
+  ConvolutionReverb convolution;
+  bool useConvolution = false;
 
   double currentSampleRate = 44100.0;
+  Oversampler::Filter oversamplingFilter = Oversampler::Filter::PolyphaseIIR;
 
   // Helper for Dry/Wet mixing
   // We'll do simple linear mix implementation inline for clarity
 
   void processDistortion(juce::AudioBuffer<float> &buffer);
   void processTransientShaper(juce::AudioBuffer<float> &buffer);
-  void processDelay(juce::AudioBuffer<float> &buffer);
-  void processReverb(juce::AudioBuffer<float> &buffer);
 
-  std::array<EffectType, 4> chainOrder = {
-      EffectType::Distortion, EffectType::TransientShaper, EffectType::Delay,
-      EffectType::Reverb};
+  // A slot is active while its mix/amount is up or still ramping down.
+  // Bypassed slots cost next to nothing: the oversampled stages just delay
+  // the input by their latency (crossfading on the switch), delay and
+  // reverb only keep their memory filling (see keepAlive).
+  bool isSlotActive(EffectType effect) const;
+  void bypassSlot(EffectType effect, juce::AudioBuffer<float> &buffer);
+
+  // Runs (or bypasses, or sleeps through) one slot in place. `silent` is
+  // the input's silence on the way in and the output's on the way out.
+  // False if the buffer still holds the input.
+  bool runSlot(EffectType effect, juce::AudioBuffer<float> &buffer,
+               bool &silent);
+
+  // Each stage sleeps once its input is silent and its tail has played
+  // out; indexed by EffectType, so they follow the stage through reorders
+  std::array<SilenceGate, 4> gates;
+  int getTailSamples(EffectType effect) const;
+  // Delay and algorithmic reverb drop what their feedback still holds
+  void clearFeedback(EffectType effect);
+
+  EffectGraph graph;
+
+  // A new wiring waits here until the output has faded out
+  void applyTopology(const EffectGraph::Topology &topology);
+  EffectGraph::Topology pendingTopology;
+  bool topologyPending = false;
+  juce::LinearSmoothedValue<float> routingGain{1.0f};
+
+  // --- Parallel sends ---
+  // A send's processing: run in place, or queued and handed to the pool as
+  // a batch once the chain moves on (or at the first sum)
+  struct BranchJob {
+    EffectType effect = EffectType::Delay;
+    int branch = 0;
+    int numSamples = 0;
+  };
+
+  void runBranch(const BranchJob &job);
+  void startBranchJobs(bool joinNow);
+  static void runBranchJob(void *context, int index);
+
+  WorkerPool *workers = nullptr;
+  WorkerPool::Batch sendBatch;
+  bool parallelSends = true;
+
+  // Per branch: the silence of what's in it, and whether it holds a wet
+  // signal worth summing (a skipped or bypassed send adds nothing)
+  std::array<bool, EffectGraph::maxBranches> branchSilent{};
+  std::array<bool, EffectGraph::maxBranches> branchLive{};
+
+  std::array<BranchJob, EffectGraph::maxBranches> branchJobs{};
+  int numBranchJobs = 0; // This block's so far
+  int numStarted = 0;    // Of those, run or handed to the pool
+  int batchFirst = 0;    // The pool's current batch starts here
+
+  // A send on a worker can't share the chain's arena, so each branch has
+  // its own, sized like it
+  std::array<ScratchArena, EffectGraph::maxBranches> branchArenas;
+  void setSlotArena(EffectType effect, ScratchArena *arena);
 };
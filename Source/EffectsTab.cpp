@@ -14,6 +14,24 @@ EffectsTab::EffectsTab(HowlingWolvesAudioProcessor &p) : audioProcessor(p) {
   setupKnob(distMixSlider, "Mix", distMixAttachment, "distMix");
   distMixSlider.setTooltip("Blends the distorted signal.");
 
+  addAndMakeVisible(oversamplingBox);
+  oversamplingBox.addItemList(juce::StringArray{"Off", "2x", "4x", "8x"}, 1);
+  oversamplingBox.setJustificationType(juce::Justification::centred);
+  oversamplingBox.setTooltip(
+      "Oversamples Distortion and Bite to keep high drive free of aliasing.");
+  oversamplingAttachment =
+      std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+          audioProcessor.getAPVTS(), "oversampling", oversamplingBox);
+
+  addAndMakeVisible(osModeBox);
+  osModeBox.addItemList(juce::StringArray{"Low Latency", "Linear Phase"}, 1);
+  osModeBox.setJustificationType(juce::Justification::centred);
+  osModeBox.setTooltip("Linear Phase keeps transients intact but adds more "
+                       "latency.");
+  osModeAttachment =
+      std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+          audioProcessor.getAPVTS(), "osMode", osModeBox);
+
   // --- Delay ---
   addAndMakeVisible(delayLabel);
   delayLabel.setText("DELAY", juce::dontSendNotification);
@@ -30,6 +48,30 @@ EffectsTab::EffectsTab(HowlingWolvesAudioProcessor &p) : audioProcessor(p) {
   setupKnob(delayMixSlider, "Mix", delayMixAttachment, "delayMix");
   delayMixSlider.setTooltip("Blends the delayed signal.");
 
+  setupKnob(delayToneSlider, "Tone", delayToneAttachment, "delayTone");
+  delayToneSlider.setTooltip("Darkens each repeat. Fully up leaves the "
+                             "feedback unfiltered.");
+
+  addAndMakeVisible(delaySyncToggle);
+  delaySyncToggle.setTooltip("Locks the delay time to the host tempo.");
+  delaySyncAttachment =
+      std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+          audioProcessor.getAPVTS(), "delaySync", delaySyncToggle);
+
+  addAndMakeVisible(delayDivisionBox);
+  delayDivisionBox.addItemList(DelayEngine::getDivisionNames(), 1);
+  delayDivisionBox.setJustificationType(juce::Justification::centred);
+  delayDivisionBox.setTooltip("Note value of each repeat while synced.");
+  delayDivisionAttachment =
+      std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+          audioProcessor.getAPVTS(), "delayDivision", delayDivisionBox);
+
+  addAndMakeVisible(delayPingPongToggle);
+  delayPingPongToggle.setTooltip("Bounces the repeats between the channels.");
+  delayPingPongAttachment =
+      std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+          audioProcessor.getAPVTS(), "delayPingPong", delayPingPongToggle);
+
   // --- Reverb ---
   addAndMakeVisible(reverbLabel);
   reverbLabel.setText("REVERB", juce::dontSendNotification);
@@ -46,6 +88,30 @@ EffectsTab::EffectsTab(HowlingWolvesAudioProcessor &p) : audioProcessor(p) {
   setupKnob(reverbMixSlider, "Mix", reverbMixAttachment, "REVERB_MIX");
   reverbMixSlider.setTooltip("Blends the reverb signal.");
 
+  addAndMakeVisible(fxQualityBox);
+  fxQualityBox.addItemList(juce::StringArray{"Eco", "High"}, 1);
+  fxQualityBox.setJustificationType(juce::Justification::centred);
+  fxQualityBox.setTooltip("High doubles the reverb's delay lines for a "
+                          "denser tail, at twice the CPU.");
+  fxQualityAttachment =
+      std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+          audioProcessor.getAPVTS(), "fxQuality", fxQualityBox);
+
+  addAndMakeVisible(reverbModeBox);
+  reverbModeBox.addItemList(juce::StringArray{"Algorithmic", "Convolution"},
+                            1);
+  reverbModeBox.setJustificationType(juce::Justification::centred);
+  reverbModeBox.setTooltip("Convolution plays an impulse response (a "
+                           "generated cave until you load one).");
+  reverbModeAttachment =
+      std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+          audioProcessor.getAPVTS(), "roomMode", reverbModeBox);
+
+  addAndMakeVisible(impulseButton);
+  impulseButton.setButtonText("IR...");
+  impulseButton.onClick = [this] { showImpulseMenu(); };
+  updateImpulseButton();
+
   // --- Bite ---
   addAndMakeVisible(biteLabel);
   biteLabel.setText("BITE", juce::dontSendNotification);
@@ -56,6 +122,14 @@ EffectsTab::EffectsTab(HowlingWolvesAudioProcessor &p) : audioProcessor(p) {
   biteSlider.setTooltip(
       "Adds aggressive bit-crushing and sample rate reduction.");
 
+  addAndMakeVisible(biteLookaheadToggle);
+  biteLookaheadToggle.setTooltip("Shapes each attack from its very start. "
+                                 "Adds 2 ms of latency.");
+  biteLookaheadAttachment =
+      std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+          audioProcessor.getAPVTS(), "transientLookahead",
+          biteLookaheadToggle);
+
   // --- Hunt ---
   addAndMakeVisible(huntLabel);
   huntLabel.setText("THE HUNT", juce::dontSendNotification);
@@ -97,10 +171,10 @@ EffectsTab::EffectsTab(HowlingWolvesAudioProcessor &p) : audioProcessor(p) {
   chainLabel.setColour(juce::Label::textColourId, WolfColors::ACCENT_CYAN);
 
   addAndMakeVisible(chainBox);
-  chainBox.addItemList(
-      juce::StringArray{"Standard", "Ethereal", "Chaos", "Reverse"}, 1);
+  chainBox.addItemList(EffectGraph::getPresetNames(), 1);
   chainBox.setJustificationType(juce::Justification::centred);
-  chainBox.setTooltip("Reorders the effects chain.");
+  chainBox.setTooltip("Reorders the effects chain, or runs Delay and Reverb "
+                      "as parallel sends.");
   chainAttachment =
       std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
           audioProcessor.getAPVTS(), "CHAIN_ORDER", chainBox);
@@ -108,6 +182,48 @@ EffectsTab::EffectsTab(HowlingWolvesAudioProcessor &p) : audioProcessor(p) {
 
 EffectsTab::~EffectsTab() {}
 
+void EffectsTab::showImpulseMenu() {
+  juce::PopupMenu menu;
+  menu.addItem(1, "Load Impulse Response...");
+  menu.addItem(2, "Built-in Cave", true,
+               audioProcessor.getImpulseResponseFile() == juce::File());
+
+  menu.showMenuAsync(
+      juce::PopupMenu::Options().withTargetComponent(&impulseButton),
+      [this](int result) {
+        if (result == 2) {
+          audioProcessor.clearImpulseResponse();
+          updateImpulseButton();
+          return;
+        }
+        if (result != 1)
+          return;
+
+        impulseChooser = std::make_unique<juce::FileChooser>(
+            "Select Impulse Response",
+            juce::File::getSpecialLocation(juce::File::userMusicDirectory),
+            "*.wav;*.aif;*.aiff;*.flac");
+
+        impulseChooser->launchAsync(
+            juce::FileBrowserComponent::openMode |
+                juce::FileBrowserComponent::canSelectFiles,
+            [this](const juce::FileChooser &fc) {
+              auto file = fc.getResult();
+              if (file.existsAsFile()) {
+                audioProcessor.loadImpulseResponse(file);
+                updateImpulseButton();
+              }
+            });
+      });
+}
+
+void EffectsTab::updateImpulseButton() {
+  auto file = audioProcessor.getImpulseResponseFile();
+  impulseButton.setTooltip(file == juce::File()
+                               ? juce::String("Impulse response: built-in cave")
+                               : "Impulse response: " + file.getFileName());
+}
+
 void EffectsTab::setupKnob(
     juce::Slider &slider, const juce::String &name,
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
@@ -169,6 +285,8 @@ void EffectsTab::paint(juce::Graphics &g) {
              juce::Justification::centred);
   g.drawText("Mix", delayMixSlider.getBounds().translated(0, 65),
              juce::Justification::centred);
+  g.drawText("Tone", delayToneSlider.getBounds().translated(0, 65),
+             juce::Justification::centred);
 
   // Reverb
   g.drawText("Size", reverbSizeSlider.getBounds().translated(0, 65),
@@ -196,6 +314,12 @@ void EffectsTab::resized() {
 
   // --- Distortion Layout ---
   distLabel.setBounds(distArea.removeFromTop(30));
+
+  auto osArea = distArea.removeFromBottom(30);
+  oversamplingBox.setBounds(
+      osArea.removeFromLeft(osArea.getWidth() * 2 / 5).reduced(2));
+  osModeBox.setBounds(osArea.reduced(2));
+
   juce::FlexBox distKnobs;
   distKnobs.justifyContent = juce::FlexBox::JustifyContent::center;
   distKnobs.alignItems = juce::FlexBox::AlignItems::center;
@@ -209,6 +333,15 @@ void EffectsTab::resized() {
 
   // --- Delay Layout ---
   delayLabel.setBounds(delayArea.removeFromTop(30));
+
+  auto delayOptions = delayArea.removeFromBottom(30);
+  const int optionWidth = delayOptions.getWidth() / 3;
+  delaySyncToggle.setBounds(
+      delayOptions.removeFromLeft(optionWidth).reduced(2));
+  delayDivisionBox.setBounds(
+      delayOptions.removeFromLeft(optionWidth).reduced(2));
+  delayPingPongToggle.setBounds(delayOptions.reduced(2));
+
   juce::FlexBox delayKnobs;
   delayKnobs.justifyContent = juce::FlexBox::JustifyContent::center;
   delayKnobs.alignItems = juce::FlexBox::AlignItems::center;
@@ -225,10 +358,19 @@ void EffectsTab::resized() {
                            .withWidth(60)
                            .withHeight(60)
                            .withMargin(5));
+  delayKnobs.items.add(juce::FlexItem(delayToneSlider)
+                           .withWidth(60)
+                           .withHeight(60)
+                           .withMargin(5));
   delayKnobs.performLayout(delayArea);
 
   // --- Reverb Layout ---
   reverbLabel.setBounds(reverbArea.removeFromTop(30));
+  auto reverbModeRow = reverbArea.removeFromBottom(30);
+  impulseButton.setBounds(
+      reverbModeRow.removeFromRight(reverbModeRow.getWidth() / 3).reduced(2));
+  reverbModeBox.setBounds(reverbModeRow.reduced(2));
+  fxQualityBox.setBounds(reverbArea.removeFromBottom(30).reduced(2));
   juce::FlexBox reverbKnobs;
   reverbKnobs.justifyContent = juce::FlexBox::JustifyContent::center;
   reverbKnobs.alignItems = juce::FlexBox::AlignItems::center;
@@ -258,6 +400,7 @@ void EffectsTab::resized() {
   auto biteArea = specialArea.removeFromTop(specialArea.getHeight() /
                                             2); // Half remaining for Bite
   biteLabel.setBounds(biteArea.removeFromTop(20));
+  biteLookaheadToggle.setBounds(biteArea.removeFromBottom(24).reduced(2));
   biteSlider.setBounds(biteArea.reduced(5));
 
   // Remaining is Hunt
@@ -23,12 +23,25 @@ private:
       distDriveAttachment, distMixAttachment;
   juce::Label distLabel;
 
+  // Oversampling (Distortion and Bite)
+  juce::ComboBox oversamplingBox, osModeBox;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      oversamplingAttachment, osModeAttachment;
+
   // Delay
   juce::GroupComponent delayGroup;
-  juce::Slider delayTimeSlider, delayFeedbackSlider, delayMixSlider;
+  juce::Slider delayTimeSlider, delayFeedbackSlider, delayMixSlider,
+      delayToneSlider;
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
-      delayTimeAttachment, delayFeedbackAttachment, delayMixAttachment;
+      delayTimeAttachment, delayFeedbackAttachment, delayMixAttachment,
+      delayToneAttachment;
   juce::Label delayLabel;
+  juce::ToggleButton delaySyncToggle{"Sync"}, delayPingPongToggle{"Ping-Pong"};
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment>
+      delaySyncAttachment, delayPingPongAttachment;
+  juce::ComboBox delayDivisionBox;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      delayDivisionAttachment;
 
   // Reverb
   juce::GroupComponent reverbGroup;
@@ -36,12 +49,23 @@ private:
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
       reverbSizeAttachment, reverbDampingAttachment, reverbMixAttachment;
   juce::Label reverbLabel;
+  juce::ComboBox fxQualityBox;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      fxQualityAttachment;
+  juce::ComboBox reverbModeBox;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      reverbModeAttachment;
+  juce::TextButton impulseButton;
+  std::unique_ptr<juce::FileChooser> impulseChooser;
 
   // Bite
   juce::Label biteLabel;
   juce::Slider biteSlider;
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
       biteAttachment;
+  juce::ToggleButton biteLookaheadToggle{"Lookahead"};
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment>
+      biteLookaheadAttachment;
 
   // Hunt
   juce::TextButton huntButton;
@@ -56,7 +80,9 @@ private:
   std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
       chainAttachment;
 
-  // Helper
+  // Helpers
+  void showImpulseMenu();
+  void updateImpulseButton();
   void setupKnob(
       juce::Slider &slider, const juce::String &name,
       std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
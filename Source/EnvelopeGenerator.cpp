@@ -0,0 +1,244 @@
+#include "EnvelopeGenerator.h"
+
+// Sample k (1-based) of a linear segment is start + increment * k
+template <bool multiply>
+static void writeLinear(float *dest, int numSamples, float start,
+                        float increment) {
+  for (int i = 0; i < numSamples; ++i) {
+    const float value = start + increment * (float)(i + 1);
+    dest[i] = multiply ? dest[i] * value : value;
+  }
+}
+
+// Sample k of an exponential segment is target + distance * r^k. Four
+// independent lanes (each stepping by r^4) break the dependency chain so the
+// recurrence vectorises.
+template <bool multiply>
+static void writeExponential(float *dest, int numSamples, float target,
+                             float distance, float r) {
+  float lanes[4];
+  float g = distance;
+  for (int j = 0; j < 4; ++j) {
+    g *= r;
+    lanes[j] = g;
+  }
+
+  const float r4 = (r * r) * (r * r);
+  int i = 0;
+
+  for (; i + 4 <= numSamples; i += 4) {
+    for (int j = 0; j < 4; ++j) {
+      const float value = target + lanes[j];
+      dest[i + j] = multiply ? dest[i + j] * value : value;
+      lanes[j] *= r4;
+    }
+  }
+
+  for (int j = 0; i < numSamples; ++i, ++j) {
+    const float value = target + lanes[j];
+    dest[i] = multiply ? dest[i] * value : value;
+  }
+}
+
+void EnvelopeGenerator::setSampleRate(double newSampleRate) {
+  jassert(newSampleRate > 0.0);
+  sampleRate = newSampleRate;
+
+  if (state != State::Idle)
+    startSegment(state);
+}
+
+void EnvelopeGenerator::setParameters(
+    const juce::ADSR::Parameters &newParameters) {
+  // Called every block with the same values; only re-plan on a real change
+  if (newParameters.attack == parameters.attack &&
+      newParameters.decay == parameters.decay &&
+      newParameters.sustain == parameters.sustain &&
+      newParameters.release == parameters.release)
+    return;
+
+  parameters = newParameters;
+
+  // Re-plan the running segment from where the envelope is now
+  if (state != State::Idle)
+    startSegment(state);
+}
+
+void EnvelopeGenerator::setCurve(Curve newCurve) {
+  if (curve == newCurve)
+    return;
+
+  curve = newCurve;
+
+  if (state == State::Decay || state == State::Release)
+    startSegment(state);
+}
+
+void EnvelopeGenerator::noteOn() { startSegment(State::Attack); }
+
+void EnvelopeGenerator::noteOff() {
+  if (state != State::Idle)
+    startSegment(State::Release);
+}
+
+void EnvelopeGenerator::reset() {
+  envelopeVal = 0.0f;
+  samplesLeft = 0;
+  state = State::Idle;
+}
+
+void EnvelopeGenerator::startSegment(State newState) {
+  state = newState;
+  exponential = false;
+
+  switch (state) {
+  case State::Attack:
+    if (parameters.attack <= 0.0f || envelopeVal >= 1.0f) {
+      envelopeVal = 1.0f;
+      startSegment(State::Decay);
+      return;
+    }
+    segmentTarget = 1.0f;
+    increment = (float)(1.0 / (parameters.attack * sampleRate));
+    samplesLeft = juce::jmax(
+        1, (int)std::ceil((segmentTarget - envelopeVal) / increment));
+    break;
+
+  case State::Decay:
+    if (parameters.decay <= 0.0f || envelopeVal <= parameters.sustain) {
+      startSegment(State::Sustain);
+      return;
+    }
+    segmentTarget = parameters.sustain;
+    if (curve == Curve::Exponential) {
+      exponential = true;
+      samplesLeft =
+          juce::jmax(1, juce::roundToInt(parameters.decay * sampleRate));
+    } else {
+      increment = -(float)((1.0 - parameters.sustain) /
+                           (parameters.decay * sampleRate));
+      samplesLeft = juce::jmax(
+          1, (int)std::ceil((envelopeVal - segmentTarget) / -increment));
+    }
+    break;
+
+  case State::Sustain:
+    envelopeVal = parameters.sustain;
+    samplesLeft = 0;
+    break;
+
+  case State::Release:
+    if (parameters.release <= 0.0f || envelopeVal <= 0.0f) {
+      reset();
+      return;
+    }
+    segmentTarget = 0.0f;
+    if (curve == Curve::Exponential) {
+      exponential = true;
+      samplesLeft =
+          juce::jmax(1, juce::roundToInt(parameters.release * sampleRate));
+    } else {
+      // Same as juce::ADSR: release time is measured from the current level
+      increment = -(float)(envelopeVal / (parameters.release * sampleRate));
+      samplesLeft =
+          juce::jmax(1, (int)std::ceil(envelopeVal / -increment));
+    }
+    break;
+
+  case State::Idle:
+    reset();
+    break;
+  }
+
+  // Exponential segments fall 60dB over their length, then snap to target
+  if (exponential)
+    multiplier = (float)std::pow(0.001, 1.0 / samplesLeft);
+}
+
+void EnvelopeGenerator::finishSegment() {
+  envelopeVal = segmentTarget;
+
+  switch (state) {
+  case State::Attack:
+    startSegment(State::Decay);
+    break;
+  case State::Decay:
+    startSegment(State::Sustain);
+    break;
+  case State::Release:
+    reset();
+    break;
+  default:
+    break;
+  }
+}
+
+template <bool multiply>
+void EnvelopeGenerator::process(float *const *channels, int numChannels,
+                                int offset, int numSamples) {
+  int pos = 0;
+
+  while (pos < numSamples) {
+    const int remaining = numSamples - pos;
+
+    // Flat states cover the rest of the block in one go
+    if (state == State::Idle || state == State::Sustain) {
+      for (int ch = 0; ch < numChannels; ++ch) {
+        auto *data = channels[ch] + offset + pos;
+        if (!multiply)
+          juce::FloatVectorOperations::fill(data, envelopeVal, remaining);
+        else if (envelopeVal != 1.0f)
+          juce::FloatVectorOperations::multiply(data, envelopeVal, remaining);
+      }
+      return;
+    }
+
+    const int len = juce::jmin(remaining, samplesLeft);
+    const bool endsHere = len == samplesLeft;
+    const int rampLen = endsHere ? len - 1 : len;
+
+    if (exponential) {
+      const float distance = envelopeVal - segmentTarget;
+      for (int ch = 0; ch < numChannels; ++ch)
+        writeExponential<multiply>(channels[ch] + offset + pos, rampLen,
+                                   segmentTarget, distance, multiplier);
+      envelopeVal =
+          segmentTarget + distance * std::pow(multiplier, (float)rampLen);
+    } else {
+      for (int ch = 0; ch < numChannels; ++ch)
+        writeLinear<multiply>(channels[ch] + offset + pos, rampLen,
+                              envelopeVal, increment);
+      envelopeVal += increment * (float)rampLen;
+    }
+
+    samplesLeft -= rampLen;
+    pos += rampLen;
+
+    if (endsHere) {
+      // Last sample of the segment lands exactly on its target
+      for (int ch = 0; ch < numChannels; ++ch) {
+        auto &sample = channels[ch][offset + pos];
+        sample = multiply ? sample * segmentTarget : segmentTarget;
+      }
+      ++pos;
+      samplesLeft = 0;
+      finishSegment();
+    }
+  }
+}
+
+void EnvelopeGenerator::render(float *dest, int numSamples) {
+  process<false>(&dest, 1, 0, numSamples);
+}
+
+void EnvelopeGenerator::apply(float *data, int numSamples) {
+  process<true>(&data, 1, 0, numSamples);
+}
+
+void EnvelopeGenerator::applyEnvelopeToBuffer(juce::AudioBuffer<float> &buffer,
+                                              int startSample,
+                                              int numSamples) {
+  jassert(startSample + numSamples <= buffer.getNumSamples());
+  process<true>(buffer.getArrayOfWritePointers(), buffer.getNumChannels(),
+                startSample, numSamples);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Block-based ADSR.
+    Same interface and (in Linear mode) the same response as juce::ADSR, but
+    instead of stepping a state machine per sample it works out how many
+    samples are left in the current segment up front and renders whole
+    segments with branch-free loops the compiler can vectorise.
+*/
+class EnvelopeGenerator {
+public:
+  // Shape of the decay and release segments (attack is always linear)
+  enum class Curve { Linear = 0, Exponential };
+
+  EnvelopeGenerator() = default;
+
+  void setSampleRate(double newSampleRate);
+  void setParameters(const juce::ADSR::Parameters &newParameters);
+  void setCurve(Curve newCurve);
+
+  void noteOn();
+  void noteOff();
+  void reset();
+
+  bool isActive() const { return state != State::Idle; }
+  // Holding a constant level until noteOff
+  bool isSustaining() const { return state == State::Sustain; }
+  float getCurrentValue() const { return envelopeVal; }
+
+  // Writes the next numSamples envelope values into dest
+  void render(float *dest, int numSamples);
+
+  // Multiplies data by the envelope in a single pass
+  void apply(float *data, int numSamples);
+
+  // Multi-channel version, same semantics as juce::ADSR
+  void applyEnvelopeToBuffer(juce::AudioBuffer<float> &buffer, int startSample,
+                             int numSamples);
+
+private:
+  enum class State { Idle, Attack, Decay, Sustain, Release };
+
+  template <bool multiply>
+  void process(float *const *channels, int numChannels, int offset,
+               int numSamples);
+
+  void startSegment(State newState);
+  void finishSegment();
+
+  State state = State::Idle;
+  juce::ADSR::Parameters parameters;
+  Curve curve = Curve::Linear;
+  double sampleRate = 44100.0;
+
+  float envelopeVal = 0.0f;
+
+  // Current segment: linear segments step by `increment`, exponential ones
+  // scale the distance to `segmentTarget` by `multiplier` each sample
+  float segmentTarget = 0.0f;
+  float increment = 0.0f;
+  float multiplier = 1.0f;
+  bool exponential = false;
+  int samplesLeft = 0;
+
+  JUCE_LEAK_DETECTOR(EnvelopeGenerator)
+};
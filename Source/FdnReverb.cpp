@@ -0,0 +1,369 @@
+#include "FdnReverb.h"
+
+// Line lengths in ms, spread so no two share a common period. 8 lines use
+// every second one, so both counts cover the same range.
+static constexpr float lineLengthsMs[FdnReverb::maxLines] = {
+    23.1f, 26.3f, 29.9f, 32.7f, 36.1f, 39.7f, 43.3f, 47.9f,
+    51.1f, 56.3f, 61.7f, 66.1f, 71.9f, 79.3f, 87.1f, 96.7f};
+
+// Samples per modulated read chunk (see readModulated)
+static constexpr int readChunk = 32;
+
+// Makes the wet level land near the old Freeverb's for the same settings
+static constexpr float outputGain = 0.35f;
+
+// Unnormalised Hadamard transform across the lines, one span at a time:
+// log2(n) stages of (a + b, a - b) butterflies
+static void hadamard(float *const *rows, int n, int numSamples) {
+  for (int half = 1; half < n; half *= 2)
+    for (int j = 0; j < n; j += 2 * half)
+      for (int k = j; k < j + half; ++k) {
+        auto *a = rows[k];
+        auto *b = rows[k + half];
+        for (int i = 0; i < numSamples; ++i) {
+          const float x = a[i];
+          const float y = b[i];
+          a[i] = x + y;
+          b[i] = x - y;
+        }
+      }
+}
+
+void FdnReverb::prepare(const juce::dsp::ProcessSpec &spec) {
+  sampleRate = spec.sampleRate;
+  modDepth = (float)(0.0004 * sampleRate); // +-0.4 ms of chorus
+
+  // The longest line at full modulation, plus the interpolation neighbour
+  const int longest =
+      (int)std::ceil(lineLengthsMs[maxLines - 1] * 0.001 * sampleRate +
+                     modDepth) +
+      2;
+  lines.setSize(maxLines, juce::nextPowerOfTwo(longest));
+  lineData = lines.getArrayOfWritePointers();
+  ringMask = lines.getNumSamples() - 1;
+
+  mixParam.reset(sampleRate, 0.05);
+
+  // Re-derives the line lengths for the new rate
+  const int currentLines = numLines;
+  numLines = 0;
+  setNumLines(currentLines);
+}
+
+void FdnReverb::reset() {
+  clearLines();
+  writePos = 0;
+
+  for (int l = 0; l < numLines; ++l) {
+    dampState[(size_t)l] = 0.0f;
+    modPhase[(size_t)l] =
+        juce::MathConstants<float>::twoPi * (float)l / (float)numLines;
+    currentDelay[(size_t)l] =
+        baseDelay[(size_t)l] + modDepth * std::sin(modPhase[(size_t)l]);
+  }
+}
+
+void FdnReverb::clearLines() {
+  for (int l = 0; l < lines.getNumChannels(); ++l)
+    juce::FloatVectorOperations::clear(lineData[l], lines.getNumSamples());
+}
+
+void FdnReverb::setParameters(float newSize, float newDamping, float mix) {
+  mixParam.setTargetValue(mix);
+  damping = juce::jlimit(0.0f, 1.0f, newDamping);
+
+  newSize = juce::jlimit(0.0f, 1.0f, newSize);
+  if (newSize != size) {
+    size = newSize;
+    updateLineGains();
+  }
+}
+
+void FdnReverb::setNumLines(int newLines) {
+  newLines = newLines > 8 ? maxLines : 8;
+  if (newLines == numLines)
+    return;
+
+  numLines = newLines;
+  const int step = maxLines / numLines;
+  float shortest = std::numeric_limits<float>::max();
+
+  for (int l = 0; l < numLines; ++l) {
+    const float ms = lineLengthsMs[l * step + step - 1];
+    baseDelay[(size_t)l] = (float)(ms * 0.001 * sampleRate);
+    shortest = juce::jmin(shortest, baseDelay[(size_t)l]);
+
+    // 0.1 .. ~0.7 Hz, a different rate per line
+    const double rate = 0.1 + 0.6 * l / (double)numLines;
+    modIncrement[(size_t)l] =
+        (float)(juce::MathConstants<double>::twoPi * rate / sampleRate);
+  }
+
+  // Nothing a span reads may be written by the same span
+  maxSpan = juce::jmax(1, (int)(shortest - modDepth) - 1);
+
+  updateLineGains();
+  reset();
+}
+
+// Size picks the decay time: 0.5 s .. 10 s to -60 dB
+static double getRt60(float size) { return 0.5 * std::pow(20.0, (double)size); }
+
+double FdnReverb::getTailSeconds(float size) {
+  return getRt60(juce::jlimit(0.0f, 1.0f, size)) * 100.0 / 60.0 +
+         lineLengthsMs[maxLines - 1] * 0.001;
+}
+
+int FdnReverb::getTailSamples() const {
+  // Never prepared: nothing stored
+  if (lineData == nullptr)
+    return 0;
+
+  // Lines are sorted by length, so the last one in use is the longest
+  return (int)std::ceil(baseDelay[(size_t)numLines - 1] + modDepth) + 2;
+}
+
+void FdnReverb::updateLineGains() {
+  // The matrix gains sqrt(numLines) per pass, taken back out here
+  const double rt60 = getRt60(size);
+  const double norm = 1.0 / std::sqrt((double)numLines);
+
+  for (int l = 0; l < numLines; ++l)
+    lineGain[(size_t)l] =
+        (float)(norm * std::pow(10.0, -3.0 * baseDelay[(size_t)l] /
+                                          (rt60 * sampleRate)));
+}
+
+void FdnReverb::process(juce::AudioBuffer<float> &buffer) {
+  const int numSamples = buffer.getNumSamples();
+  if (numSamples == 0 || lineData == nullptr)
+    return;
+
+  // Fully dry: only keep the lines filling
+  if (!isActive()) {
+    keepAlive(buffer);
+    return;
+  }
+
+  jassert(scratch != nullptr);
+  ScratchArena::ScopedRewind rewind(*scratch);
+  auto mix = ParameterRamp::next(mixParam, *scratch, numSamples);
+
+  const int numChannels = juce::jmin(buffer.getNumChannels(), 2);
+  const bool stereo = numChannels == 2;
+  auto *left = buffer.getWritePointer(0);
+  auto *right = stereo ? buffer.getWritePointer(1) : left;
+
+  // Whole-block wet signal, so the dry input stays intact until the end
+  auto *wetLeft = scratch->allocate(numSamples);
+  auto *wetRight = scratch->allocate(numSamples);
+
+  const int spanSize = juce::jmin(maxSpan, numSamples);
+  float *spans[maxLines] = {};
+  for (int l = 0; l < numLines; ++l)
+    spans[l] = scratch->allocate(spanSize);
+
+  // Arena full: no wet signal this block, the dry one passes (a send is
+  // silent)
+  if (scratch->hasOverflowed()) {
+    keepAlive(buffer);
+    if (wetOnly)
+      buffer.clear();
+    return;
+  }
+
+  juce::FloatVectorOperations::clear(wetLeft, numSamples);
+  juce::FloatVectorOperations::clear(wetRight, numSamples);
+
+  // Stereo: left feeds the even lines and is heard from them, right the
+  // odd ones; the matrix spreads both over everything after one pass
+  const float inputGain = stereo ? std::sqrt(2.0f / (float)numLines)
+                                 : 1.0f / std::sqrt((float)numLines);
+  const float dampCoeff = 1.0f - damping * 0.4f; // Freeverb's damping range
+
+  for (int offset = 0; offset < numSamples; offset += spanSize) {
+    const int len = juce::jmin(spanSize, numSamples - offset);
+    const int pos = writePos + offset;
+
+    for (int l = 0; l < numLines; ++l) {
+      auto &phase = modPhase[(size_t)l];
+      phase += modIncrement[(size_t)l] * (float)len;
+      if (phase > juce::MathConstants<float>::twoPi)
+        phase -= juce::MathConstants<float>::twoPi;
+
+      const float delayEnd =
+          baseDelay[(size_t)l] + modDepth * std::sin(phase);
+      readModulated(l, pos, spans[l], len, currentDelay[(size_t)l],
+                    delayEnd);
+      currentDelay[(size_t)l] = delayEnd;
+
+      juce::FloatVectorOperations::add((l & 1) != 0 ? wetRight + offset
+                                                    : wetLeft + offset,
+                                       spans[l], len);
+    }
+
+    // Damping and decay, in place: the outputs are summed already. Four
+    // lines at a time, so the recursions overlap instead of each waiting on
+    // its own previous sample.
+    for (int l = 0; l < numLines; l += 4) {
+      auto *l0 = spans[l];
+      auto *l1 = spans[l + 1];
+      auto *l2 = spans[l + 2];
+      auto *l3 = spans[l + 3];
+      float z0 = dampState[(size_t)l], z1 = dampState[(size_t)l + 1];
+      float z2 = dampState[(size_t)l + 2], z3 = dampState[(size_t)l + 3];
+      const float g0 = lineGain[(size_t)l], g1 = lineGain[(size_t)l + 1];
+      const float g2 = lineGain[(size_t)l + 2], g3 = lineGain[(size_t)l + 3];
+
+      for (int i = 0; i < len; ++i) {
+        z0 += dampCoeff * (l0[i] - z0);
+        z1 += dampCoeff * (l1[i] - z1);
+        z2 += dampCoeff * (l2[i] - z2);
+        z3 += dampCoeff * (l3[i] - z3);
+        l0[i] = g0 * z0;
+        l1[i] = g1 * z1;
+        l2[i] = g2 * z2;
+        l3[i] = g3 * z3;
+      }
+
+      dampState[(size_t)l] = z0;
+      dampState[(size_t)l + 1] = z1;
+      dampState[(size_t)l + 2] = z2;
+      dampState[(size_t)l + 3] = z3;
+    }
+
+    hadamard(spans, numLines, len);
+
+    for (int l = 0; l < numLines; ++l) {
+      const auto *input = (l & 1) != 0 ? right : left;
+      juce::FloatVectorOperations::addWithMultiply(spans[l], input + offset,
+                                                   inputGain, len);
+      writeSpan(l, pos, spans[l], len);
+    }
+  }
+
+  writePos = (writePos + numSamples) & ringMask;
+
+  // Mono: both halves of the network go to the one channel
+  if (!stereo)
+    juce::FloatVectorOperations::add(wetLeft, wetRight, numSamples);
+
+  // Equal dry/wet crossfade, or just the wet side as a send
+  float *const outputs[2] = {left, right};
+  const float *const wets[2] = {wetLeft, wetRight};
+
+  for (int ch = 0; ch < numChannels; ++ch) {
+    auto *data = outputs[ch];
+    const auto *wet = wets[ch];
+
+    if (wetOnly && mix.isConstant()) {
+      juce::FloatVectorOperations::copyWithMultiply(
+          data, wet, mix.value * outputGain, numSamples);
+    } else if (wetOnly) {
+      juce::FloatVectorOperations::multiply(data, wet, mix.values,
+                                            numSamples);
+      juce::FloatVectorOperations::multiply(data, outputGain, numSamples);
+    } else if (mix.isConstant()) {
+      juce::FloatVectorOperations::multiply(data, 1.0f - mix.value,
+                                            numSamples);
+      juce::FloatVectorOperations::addWithMultiply(
+          data, wet, mix.value * outputGain, numSamples);
+    } else {
+      for (int i = 0; i < numSamples; ++i)
+        data[i] += mix.values[i] * (wet[i] * outputGain - data[i]);
+    }
+  }
+}
+
+void FdnReverb::keepAlive(const juce::AudioBuffer<float> &buffer) {
+  const int numSamples = buffer.getNumSamples();
+  if (numSamples == 0 || lineData == nullptr)
+    return;
+
+  const int numChannels = juce::jmin(buffer.getNumChannels(), 2);
+  const bool stereo = numChannels == 2;
+  const float inputGain = stereo ? std::sqrt(2.0f / (float)numLines)
+                                 : 1.0f / std::sqrt((float)numLines);
+
+  // As process() writes with every line's feedback at zero. Only the last
+  // ring's worth of a long block can still be read back.
+  const int ringSize = ringMask + 1;
+  const int skipped = juce::jmax(0, numSamples - ringSize);
+  const int len = numSamples - skipped;
+  const int first = (writePos + skipped) & ringMask;
+  const int head = juce::jmin(len, ringSize - first);
+
+  for (int l = 0; l < numLines; ++l) {
+    const auto *input =
+        buffer.getReadPointer((l & 1) != 0 && stereo ? 1 : 0, skipped);
+    juce::FloatVectorOperations::copyWithMultiply(lineData[l] + first, input,
+                                                  inputGain, head);
+    juce::FloatVectorOperations::copyWithMultiply(lineData[l], input + head,
+                                                  inputGain, len - head);
+  }
+
+  writePos = (writePos + numSamples) & ringMask;
+  advanceModulation(numSamples);
+}
+
+void FdnReverb::advanceModulation(int numSamples) {
+  // Picks up where a running network would be, so waking doesn't jump
+  for (int l = 0; l < numLines; ++l) {
+    auto &phase = modPhase[(size_t)l];
+    phase = std::fmod(phase + modIncrement[(size_t)l] * (float)numSamples,
+                      juce::MathConstants<float>::twoPi);
+    currentDelay[(size_t)l] = baseDelay[(size_t)l] + modDepth * std::sin(phase);
+  }
+}
+
+void FdnReverb::readModulated(int line, int pos, float *dest,
+                              int numSamples, float delayStart,
+                              float delayEnd) const {
+  const auto *ring = lineData[line];
+  const float slope = (delayEnd - delayStart) / (float)numSamples;
+
+  // The modulation moves well under a sample per chunk, so the whole part
+  // of the delay usually holds: both taps are then contiguous runs and
+  // the blend vectorises. Chunks that cross a sample or the ring's end
+  // read sample by sample.
+  for (int start = 0; start < numSamples; start += readChunk) {
+    const int len = juce::jmin(readChunk, numSamples - start);
+    const float first = delayStart + slope * (float)(start + 1);
+    const float last = delayStart + slope * (float)(start + len);
+    const int delayInt = (int)first;
+    const int newest = (pos + start - delayInt) & ringMask;
+
+    if ((int)last == delayInt && newest >= 1 &&
+        newest + len <= ringMask + 1) {
+      const float *newer = ring + newest;
+      const float *older = newer - 1;
+      const float fracStart = first - (float)delayInt;
+
+      for (int i = 0; i < len; ++i)
+        dest[start + i] = newer[i] + (fracStart + slope * (float)i) *
+                                         (older[i] - newer[i]);
+      continue;
+    }
+
+    for (int i = start; i < start + len; ++i) {
+      const float delay = delayStart + slope * (float)(i + 1);
+      const int whole = (int)delay;
+      const float frac = delay - (float)whole;
+
+      const int newer = pos + i - whole;
+      const float a = ring[newer & ringMask];
+      const float b = ring[(newer - 1) & ringMask];
+      dest[i] = a + frac * (b - a);
+    }
+  }
+}
+
+void FdnReverb::writeSpan(int line, int pos, const float *src,
+                          int numSamples) {
+  const int first = pos & ringMask;
+  const int head = juce::jmin(numSamples, ringMask + 1 - first);
+
+  juce::FloatVectorOperations::copy(lineData[line] + first, src, head);
+  juce::FloatVectorOperations::copy(lineData[line], src + head,
+                                    numSamples - head);
+}
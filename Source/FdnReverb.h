@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ParameterRamp.h"
+#include "ScratchArena.h"
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Feedback delay network reverb: 8 or 16 delay lines fed back through a
+    Hadamard matrix, each with its own damping lowpass and a slowly
+    modulated length.
+
+    Like the delay, it runs in spans no longer than its shortest line, so
+    every stage but the damping filter is a loop over a whole span of one
+    line (the Hadamard butterflies are plain add/subtract of two spans) and
+    vectorises. The modulation moves each read position linearly across a
+    span, which is indistinguishable from a per-sample sine at these rates.
+
+    Size sets the decay time, damping the high frequency loss per pass and
+    mix is an equal dry/wet crossfade.
+*/
+class FdnReverb {
+public:
+  static constexpr int maxLines = 16;
+
+  FdnReverb() = default;
+
+  void prepare(const juce::dsp::ProcessSpec &spec);
+  void reset();
+  void setScratchArena(ScratchArena *arena) { scratch = arena; }
+
+  // All 0..1, as the old Freeverb parameters
+  void setParameters(float size, float damping, float mix);
+  // 8 (cheaper) or 16 (denser). Changing it clears the tail.
+  void setNumLines(int lines);
+  int getNumLines() const { return numLines; }
+  // As a send: outputs only the reverb, scaled by the mix
+  void setWetOnly(bool enabled) { wetOnly = enabled; }
+
+  void process(juce::AudioBuffer<float> &buffer);
+
+  // Mix up, or on its way down
+  bool isActive() const {
+    return mixParam.isSmoothing() || mixParam.getTargetValue() > 0.0f;
+  }
+  // While inactive: feeds the input into the lines with no feedback or
+  // output, so turning the mix back up starts from a live network
+  void keepAlive(const juce::AudioBuffer<float> &buffer);
+
+  // How long the output can stay quiet with the lines still holding sound
+  int getTailSamples() const;
+
+  // Decay to -100 dB for a size, for the host's tail length
+  static double getTailSeconds(float size);
+
+private:
+  void updateLineGains();
+  void clearLines();
+  void advanceModulation(int numSamples);
+
+  // One span of a line's output, its read position moving from
+  // delayStart to delayEnd (in samples)
+  void readModulated(int line, int pos, float *dest, int numSamples,
+                     float delayStart, float delayEnd) const;
+  void writeSpan(int line, int pos, const float *src, int numSamples);
+
+  ScratchArena *scratch = nullptr;
+
+  juce::LinearSmoothedValue<float> mixParam;
+  float size = 0.5f;
+  float damping = 0.5f;
+  int numLines = 8;
+  bool wetOnly = false;
+
+  // Per line (only the first numLines are in use)
+  std::array<float, maxLines> baseDelay{};  // Samples
+  std::array<float, maxLines> lineGain{};   // Decay, matrix norm included
+  std::array<float, maxLines> dampState{};
+  std::array<float, maxLines> modPhase{};   // Radians
+  std::array<float, maxLines> modIncrement{};
+  std::array<float, maxLines> currentDelay{}; // At the end of the last span
+
+  // Delay memory, one power-of-two ring per line sharing a mask
+  juce::AudioBuffer<float> lines;
+  float *const *lineData = nullptr;
+  int ringMask = 0;
+  int writePos = 0;
+  int maxSpan = 1; // Shortest line minus the modulation depth
+
+  double sampleRate = 44100.0;
+  float modDepth = 0.0f; // Samples
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FdnReverb)
+};
@@ -1,4 +1,5 @@
 #pragma once
+#include "FormantBank.h"
 #include <JuceHeader.h>
 
 class FilterProcessor {
@@ -16,19 +17,18 @@ public:
   void setResonance(float resonance);
   void setVowel(float vowelPos); // 0.0 (A) to 1.0 (U)
 
-private:
-  struct FormantBand {
-    juce::dsp::IIR::Filter<float> filter;
-    float targetFreq = 1000.0f;
-    float targetQ = 1.0f;
-    float targetGain = 1.0f;
-  };
+  // The filterRes parameter (0..1) as the SVF's Q, the same for the
+  // per-voice filters and the paraphonic bus so a preset sounds alike in
+  // either mode. Floored, as a Q of 0 has no defined response.
+  static float resonanceToQ(float resonance) {
+    return juce::jmax(0.1f, resonance);
+  }
 
+private:
   // 5 parallel bands for formants
-  std::array<FormantBand, 5> formantBands;
-  void updateFormantCoefficients();
+  FormantBank formants;
 
-  float vowelPosition = 0.0f; // 0.0 - 1.0
+  float lastResonance = -1.0f;
   juce::dsp::StateVariableTPTFilter<float> filter;
   FilterType currentType = LowPass;
   float sampleRate = 44100.0f;
@@ -0,0 +1,163 @@
+#include "FormantBank.h"
+
+namespace {
+// Approximate Formant Frequencies (Male)
+// Vowel: A, E, I, O, U
+// Each has F1, F2, F3, F4, F5
+const float formantFreqs[5][FormantBank::numBands] = {
+    {730.0f, 1090.0f, 2440.0f, 3500.0f, 4500.0f}, // A
+    {530.0f, 1840.0f, 2480.0f, 3500.0f, 4500.0f}, // E
+    {270.0f, 2290.0f, 3010.0f, 3500.0f, 4500.0f}, // I
+    {570.0f, 840.0f, 2410.0f, 3500.0f, 4500.0f},  // O
+    {300.0f, 870.0f, 2240.0f, 3500.0f, 4500.0f}   // U
+};
+
+// Gains for bands (empirically tweaked for balance)
+const float formantGains[5][FormantBank::numBands] = {
+    {1.0f, 0.5f, 0.2f, 0.1f, 0.05f}, // A
+    {1.0f, 0.3f, 0.2f, 0.1f, 0.05f}, // E
+    {0.8f, 1.0f, 0.2f, 0.1f, 0.05f}, // I
+    {1.0f, 0.6f, 0.2f, 0.1f, 0.05f}, // O
+    {1.0f, 0.5f, 0.1f, 0.1f, 0.05f}  // U
+};
+} // namespace
+
+FormantBank::FormantBank() {
+  updateTarget();
+  current = target;
+  targetChanged = false;
+}
+
+void FormantBank::prepare(double newSampleRate, int numChannels) {
+  sampleRate = newSampleRate;
+  state.assign((size_t)juce::jmax(1, numChannels), State{});
+  updateTarget();
+  reset();
+}
+
+void FormantBank::reset() {
+  std::fill(state.begin(), state.end(), State{});
+  current = target;
+  targetChanged = false;
+}
+
+void FormantBank::setVowel(float position) {
+  position = juce::jlimit(0.0f, 1.0f, position);
+  if (position == vowel)
+    return;
+
+  vowel = position;
+  updateTarget();
+}
+
+void FormantBank::setResonance(float newResonance) {
+  if (newResonance == resonance)
+    return;
+
+  resonance = newResonance;
+  updateTarget();
+}
+
+void FormantBank::updateTarget() {
+  // Interpolate between vowels
+  // 0 = A, 1 = E, 2 = I, 3 = O, 4 = U
+  const float position = vowel * 4.0f;
+  const int index1 = juce::jmin((int)position, 4);
+  const int index2 = juce::jmin(index1 + 1, 4);
+  const float alpha = position - (float)index1;
+
+  // Formants are fairly resonant: twice the filter Q, so resonance goes
+  // from "mumbling" to "singing"
+  const double invQ = 1.0 / ((0.5 + resonance * 9.5) * 2.0);
+  const double nyquist = sampleRate * 0.5;
+
+  for (int i = 0; i < numBands; ++i) {
+    const float f1 = formantFreqs[index1][i];
+    const float f2 = formantFreqs[index2][i];
+    const double freq = juce::jmin(f1 + (f2 - f1) * alpha,
+                                   (float)(nyquist * 0.95));
+
+    const float g1 = formantGains[index1][i];
+    const float g2 = formantGains[index2][i];
+    const float gain = g1 + (g2 - g1) * alpha;
+
+    // Same bilinear bandpass as IIR::Coefficients::makeBandPass (0 dB at
+    // the centre), without the heap-allocated coefficient object
+    const double n = 1.0 / std::tan(juce::MathConstants<double>::pi * freq /
+                                     sampleRate);
+    const double nSquared = n * n;
+    const double c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+    target.b0[i] = (float)(c1 * n * invQ) * gain;
+    target.a1[i] = (float)(c1 * 2.0 * (1.0 - nSquared));
+    target.a2[i] = (float)(c1 * (1.0 - invQ * n + nSquared));
+  }
+
+  targetChanged = true;
+}
+
+void FormantBank::process(float *const *channels, int numChannels,
+                          int numSamples) {
+  if (numSamples <= 0)
+    return;
+
+  const int channelsToUse = juce::jmin(numChannels, (int)state.size());
+
+  if (!targetChanged) {
+    for (int ch = 0; ch < channelsToUse; ++ch)
+      processChannel<false>(channels[ch], state[(size_t)ch], current,
+                            current, numSamples);
+    return;
+  }
+
+  // Per-sample increments that land on the target at the end of the block
+  Lanes step;
+  const float scale = 1.0f / (float)numSamples;
+  for (int l = 0; l < numLanes; ++l) {
+    step.b0[l] = (target.b0[l] - current.b0[l]) * scale;
+    step.a1[l] = (target.a1[l] - current.a1[l]) * scale;
+    step.a2[l] = (target.a2[l] - current.a2[l]) * scale;
+  }
+
+  for (int ch = 0; ch < channelsToUse; ++ch)
+    processChannel<true>(channels[ch], state[(size_t)ch], current, step,
+                         numSamples);
+
+  current = target;
+  targetChanged = false;
+}
+
+template <bool ramping>
+void FormantBank::processChannel(float *data, State &channelState,
+                                 const Lanes &start, const Lanes &step,
+                                 int numSamples) {
+  // Local copies, so the lanes stay in registers across the block
+  Lanes c = start;
+  State s = channelState;
+
+  for (int i = 0; i < numSamples; ++i) {
+    const float x = data[i];
+    float y[numLanes];
+
+    // Transposed direct form II, every band at once
+    for (int l = 0; l < numLanes; ++l) {
+      if (ramping) {
+        c.b0[l] += step.b0[l];
+        c.a1[l] += step.a1[l];
+        c.a2[l] += step.a2[l];
+      }
+
+      y[l] = c.b0[l] * x + s.z1[l];
+      s.z1[l] = s.z2[l] - c.a1[l] * y[l];
+      s.z2[l] = -c.b0[l] * x - c.a2[l] * y[l];
+    }
+
+    float sum = 0.0f;
+    for (int l = 0; l < numLanes; ++l)
+      sum += y[l];
+
+    data[i] = sum;
+  }
+
+  channelState = s;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Five parallel bandpass biquads tuned to the formants of a vowel, run as
+    one bank: each band is a lane of small fixed-size arrays, so the inner
+    loop over the bands has a constant trip count and vectorises, and their
+    outputs are summed in the same pass.
+
+    Coefficients live inline and are only recomputed when the vowel or
+    resonance moves. Each block ramps them per sample from where the last
+    block ended to the new target, so vowel sweeps don't zipper. Stable
+    biquads form a convex set, so every point on the ramp is stable too.
+    The band gains are folded into b0/b2.
+
+    Nothing is allocated outside prepare().
+*/
+class FormantBank {
+public:
+  static constexpr int numBands = 5;
+  // Padded to a vector width; the spare lanes have zero coefficients
+  static constexpr int numLanes = 8;
+
+  FormantBank();
+
+  void prepare(double newSampleRate, int numChannels);
+  // Clears the state and jumps straight to the target coefficients
+  void reset();
+
+  void setVowel(float position);      // 0.0 (A) to 1.0 (U)
+  void setResonance(float resonance); // 0..1, as the filter resonance
+
+  void process(float *const *channels, int numChannels, int numSamples);
+
+private:
+  struct alignas(32) Lanes {
+    float b0[numLanes]{}; // b1 = 0, b2 = -b0
+    float a1[numLanes]{};
+    float a2[numLanes]{};
+  };
+
+  struct alignas(32) State {
+    float z1[numLanes]{};
+    float z2[numLanes]{};
+  };
+
+  void updateTarget();
+
+  template <bool ramping>
+  static void processChannel(float *data, State &channelState,
+                             const Lanes &start, const Lanes &step,
+                             int numSamples);
+
+  Lanes current, target;
+  std::vector<State> state; // One per channel
+
+  double sampleRate = 44100.0;
+  float vowel = 0.0f;
+  float resonance = 0.5f;
+  bool targetChanged = false;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FormantBank)
+};
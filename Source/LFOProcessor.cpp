@@ -1,6 +1,32 @@
 #include "LFOProcessor.h"
 
-LFOProcessor::LFOProcessor() {}
+// One cycle of sin(2 pi x) plus a guard point, shared by every LFO
+static constexpr int sineTableSize = 512;
+
+static const std::array<float, sineTableSize + 1> &getSineTable() {
+  static const auto table = [] {
+    std::array<float, sineTableSize + 1> values{};
+    for (int i = 0; i <= sineTableSize; ++i)
+      values[(size_t)i] = (float)std::sin(juce::MathConstants<double>::twoPi *
+                                          i / sineTableSize);
+    return values;
+  }();
+  return table;
+}
+
+// phase in [0, 1]; the mask folds a phase that rounded up to 1 back to 0
+static inline float lookupSine(const float *table, float phase) {
+  const float pos = phase * (float)sineTableSize;
+  const int index = (int)pos;
+  const float frac = pos - (float)index;
+  const int i0 = index & (sineTableSize - 1);
+  return table[i0] + frac * (table[i0 + 1] - table[i0]);
+}
+
+LFOProcessor::LFOProcessor() {
+  // Build the table here rather than on the first audio callback
+  getSineTable();
+}
 
 void LFOProcessor::prepare(double sampleRate) {
   currentSampleRate = sampleRate;
@@ -10,33 +36,88 @@ void LFOProcessor::prepare(double sampleRate) {
 
 void LFOProcessor::reset() { phase = 0.0; }
 
-float LFOProcessor::getNextSample() {
+float LFOProcessor::getValueAt(double phaseToUse) const {
   float output = 0.0f;
 
   switch (currentWaveform) {
   case Sine:
-    output = std::sin(phase * juce::MathConstants<double>::twoPi);
+    output = lookupSine(getSineTable().data(), (float)phaseToUse);
     break;
 
   case Square:
-    output = (phase < 0.5) ? 1.0f : -1.0f;
+    output = (phaseToUse < 0.5) ? 1.0f : -1.0f;
     break;
 
   case Triangle:
-    if (phase < 0.5)
-      output = -1.0f + 4.0f * phase;
+    if (phaseToUse < 0.5)
+      output = -1.0f + 4.0f * phaseToUse;
     else
-      output = 3.0f - 4.0f * phase;
+      output = 3.0f - 4.0f * phaseToUse;
     break;
   }
 
+  // Apply depth (0.0 to 1.0 range)
+  return output * currentDepth;
+}
+
+float LFOProcessor::getNextSample() {
+  float output = getValueAt(phase);
+
   // Advance phase
   phase += phaseIncrement;
   if (phase >= 1.0)
     phase -= 1.0;
 
-  // Apply depth (0.0 to 1.0 range)
-  return output * currentDepth;
+  return output;
+}
+
+float LFOProcessor::advance(int numSamples) {
+  float output = getValueAt(phase);
+
+  phase += phaseIncrement * numSamples;
+  phase -= std::floor(phase);
+
+  return output;
+}
+
+void LFOProcessor::renderBlock(float *dest, int numSamples) {
+  // Phases are computed from the block start rather than accumulated, so the
+  // loops carry no dependency between samples
+  const float start = (float)phase;
+  const float increment = (float)phaseIncrement;
+
+  switch (currentWaveform) {
+  case Sine: {
+    const float *table = getSineTable().data();
+    for (int i = 0; i < numSamples; ++i) {
+      float p = start + increment * (float)i;
+      p -= (float)(int)p;
+      dest[i] = lookupSine(table, p);
+    }
+    break;
+  }
+
+  case Square:
+    for (int i = 0; i < numSamples; ++i) {
+      float p = start + increment * (float)i;
+      p -= (float)(int)p;
+      dest[i] = (p < 0.5f) ? 1.0f : -1.0f;
+    }
+    break;
+
+  case Triangle:
+    for (int i = 0; i < numSamples; ++i) {
+      float p = start + increment * (float)i;
+      p -= (float)(int)p;
+      dest[i] = 1.0f - 4.0f * std::abs(p - 0.5f);
+    }
+    break;
+  }
+
+  juce::FloatVectorOperations::multiply(dest, currentDepth, numSamples);
+
+  phase += phaseIncrement * numSamples;
+  phase -= std::floor(phase);
 }
 
 void LFOProcessor::setWaveform(Waveform wave) { currentWaveform = wave; }
@@ -12,6 +12,12 @@ public:
   void prepare(double sampleRate);
   void reset();
   float getNextSample();
+  // Control-rate use: returns the current value and moves the phase on by
+  // numSamples in one step
+  float advance(int numSamples);
+  // Fills dest with the next numSamples values (depth applied). Sine comes
+  // from a shared lookup table, so a block costs no sin() calls at all.
+  void renderBlock(float *dest, int numSamples);
 
   void setWaveform(Waveform wave);
   void setRate(float rateHz);
@@ -22,6 +28,8 @@ public:
   float getDepth() const { return currentDepth; }
 
 private:
+  float getValueAt(double phaseToUse) const;
+
   Waveform currentWaveform = Sine;
   Target currentTarget = FilterCutoff;
   float currentRate = 1.0f;
@@ -0,0 +1,225 @@
+#include "MasterStage.h"
+
+MasterStage::MasterStage() {
+  // Hann-windowed sinc at each fractional position, normalised to unity
+  // gain at DC. Taps run from tapsBefore samples before the point.
+  for (int p = 0; p < numPhases; ++p) {
+    const double fraction = (p + 1) / (double)(numPhases + 1);
+    const double halfWidth = numTaps / 2 + 0.5;
+    double sum = 0.0;
+
+    for (int k = 0; k < numTaps; ++k) {
+      const double t = (k - tapsBefore) - fraction;
+      const double x = juce::MathConstants<double>::pi * t;
+      const double sinc = std::abs(t) < 1.0e-9 ? 1.0 : std::sin(x) / x;
+      const double window =
+          0.5 + 0.5 * std::cos(juce::MathConstants<double>::pi * t /
+                               halfWidth);
+      interpolator[p][k] = (float)(sinc * window);
+      sum += sinc * window;
+    }
+
+    for (int k = 0; k < numTaps; ++k)
+      interpolator[p][k] = (float)(interpolator[p][k] / sum);
+  }
+}
+
+void MasterStage::prepare(const juce::dsp::ProcessSpec &spec) {
+  numChannels = juce::jlimit(1, 2, (int)spec.numChannels);
+  maxBlockSize = juce::jmax(1, (int)spec.maximumBlockSize);
+
+  for (auto &gain : channelGain)
+    gain.reset(spec.sampleRate, 0.02);
+
+  ceiling = juce::Decibels::decibelsToGain(ceilingDb);
+  releaseCoefficient =
+      (float)std::exp(-1.0 / (releaseSeconds * spec.sampleRate));
+  lookahead = juce::jmax(1, juce::roundToInt(lookaheadSeconds *
+                                             spec.sampleRate));
+
+  history = lookahead + detectorDelay;
+  line.setSize((int)spec.numChannels, history + maxBlockSize);
+
+  const int minSize = juce::nextPowerOfTwo(lookahead + 2);
+  minValues.assign((size_t)minSize, 1.0f);
+  minSteps.assign((size_t)minSize, 0);
+  minMask = minSize - 1;
+  box.assign((size_t)lookahead, 1.0f);
+
+  reset();
+}
+
+void MasterStage::reset() {
+  for (auto &gain : channelGain)
+    gain.setCurrentAndTargetValue(gain.getTargetValue());
+  clearLimiter();
+}
+
+void MasterStage::clearLimiter() {
+  line.clear();
+  minFront = minCount = 0;
+  step = 0;
+  envelope = 1.0f;
+  std::fill(box.begin(), box.end(), 1.0f);
+  boxSum = (double)box.size();
+  boxPos = 0;
+}
+
+void MasterStage::setGainAndPan(float gain, float pan) {
+  if (numChannels < 2) {
+    channelGain[0].setTargetValue(gain);
+    return;
+  }
+
+  const float angle =
+      (juce::jlimit(-1.0f, 1.0f, pan) + 1.0f) *
+      (juce::MathConstants<float>::pi / 4.0f);
+  channelGain[0].setTargetValue(gain * std::cos(angle));
+  channelGain[1].setTargetValue(gain * std::sin(angle));
+}
+
+void MasterStage::setLimiter(bool enabled) {
+  if (enabled == limiterEnabled)
+    return;
+
+  limiterEnabled = enabled;
+  clearLimiter();
+}
+
+float MasterStage::popGainReductionDb() {
+  return juce::Decibels::gainToDecibels(meterGain.exchange(1.0f), -60.0f);
+}
+
+void MasterStage::process(juce::AudioBuffer<float> &buffer) {
+  jassert(scratch != nullptr);
+  const int numSamples = buffer.getNumSamples();
+
+  // The delay line holds one block at most
+  for (int start = 0; start < numSamples; start += maxBlockSize)
+    processChunk(buffer, start, juce::jmin(maxBlockSize, numSamples - start));
+}
+
+void MasterStage::processChunk(juce::AudioBuffer<float> &buffer, int start,
+                               int numSamples) {
+  ScratchArena::ScopedRewind rewind(*scratch);
+  const int channels = juce::jmin(buffer.getNumChannels(), numChannels);
+
+  std::array<ParameterRamp, 2> gains;
+  for (int ch = 0; ch < channels; ++ch)
+    gains[(size_t)ch] =
+        ParameterRamp::next(channelGain[(size_t)ch], *scratch, numSamples);
+
+  if (!limiterEnabled) {
+    for (int ch = 0; ch < channels; ++ch) {
+      auto *data = buffer.getWritePointer(ch, start);
+      const auto &gain = gains[(size_t)ch];
+      if (gain.isConstant())
+        juce::FloatVectorOperations::multiply(data, gain.value, numSamples);
+      else
+        juce::FloatVectorOperations::multiply(data, gain.values, numSamples);
+    }
+    return;
+  }
+
+  // Gained input into the line, and the block's true peak across channels
+  auto *peaks = scratch->allocate(numSamples);
+  auto *work = scratch->allocate(numSamples);
+
+  // Arena full: nothing can be checked against the ceiling, so this chunk
+  // goes out silent and the lookahead starts over
+  if (peaks == nullptr || work == nullptr) {
+    for (int ch = 0; ch < channels; ++ch)
+      buffer.clear(ch, start, numSamples);
+    clearLimiter();
+    return;
+  }
+
+  juce::FloatVectorOperations::clear(peaks, numSamples);
+
+  for (int ch = 0; ch < channels; ++ch) {
+    auto *delayed = line.getWritePointer(ch);
+    const auto *in = buffer.getReadPointer(ch, start);
+    const auto &gain = gains[(size_t)ch];
+
+    if (gain.isConstant())
+      juce::FloatVectorOperations::copyWithMultiply(delayed + history, in,
+                                                    gain.value, numSamples);
+    else
+      juce::FloatVectorOperations::multiply(delayed + history, in,
+                                            gain.values, numSamples);
+
+    // Detector points trail the newest sample by detectorDelay
+    const float *points = delayed + history - detectorDelay;
+    juce::FloatVectorOperations::abs(work, points, numSamples);
+    juce::FloatVectorOperations::max(peaks, peaks, work, numSamples);
+
+    for (const auto &taps : interpolator) {
+      const float *first = points - tapsBefore;
+      juce::FloatVectorOperations::copyWithMultiply(work, first, taps[0],
+                                                    numSamples);
+      for (int k = 1; k < numTaps; ++k)
+        juce::FloatVectorOperations::addWithMultiply(work, first + k, taps[k],
+                                                     numSamples);
+      juce::FloatVectorOperations::abs(work, work, numSamples);
+      juce::FloatVectorOperations::max(peaks, peaks, work, numSamples);
+    }
+  }
+
+  computeGains(peaks, numSamples);
+
+  // The oldest samples out through the limiter gain, the rest moved up
+  for (int ch = 0; ch < channels; ++ch) {
+    auto *delayed = line.getWritePointer(ch);
+    juce::FloatVectorOperations::multiply(buffer.getWritePointer(ch, start),
+                                          delayed, peaks, numSamples);
+    std::memmove(delayed, delayed + numSamples,
+                 (size_t)history * sizeof(float));
+  }
+}
+
+void MasterStage::computeGains(float *peaksToGains, int numSamples) {
+  const double boxScale = 1.0 / (double)lookahead;
+  float lowest = 1.0f;
+
+  for (int i = 0; i < numSamples; ++i, ++step) {
+    const float peak = peaksToGains[i];
+    const float required = peak > ceiling ? ceiling / peak : 1.0f;
+
+    // Minimum over [step - lookahead, step]: newer values evict any
+    // larger ones behind them, the front drops out of the window
+    while (minCount > 0 &&
+           minValues[(size_t)((minFront + minCount - 1) & minMask)] >=
+               required)
+      --minCount;
+    const auto back = (size_t)((minFront + minCount) & minMask);
+    minValues[back] = required;
+    minSteps[back] = step;
+    ++minCount;
+
+    while (minSteps[(size_t)minFront] < step - lookahead) {
+      minFront = (minFront + 1) & minMask;
+      --minCount;
+    }
+
+    // Down at once, back up at the release rate (never above the minimum)
+    const float held = minValues[(size_t)minFront];
+    envelope = held < envelope ? held : held + (envelope - held) *
+                                                   releaseCoefficient;
+
+    // Averaged over the lookahead, so the gain is a smooth ramp that
+    // bottoms out as the peak leaves the line
+    boxSum += envelope - box[(size_t)boxPos];
+    box[(size_t)boxPos] = envelope;
+    boxPos = boxPos + 1 < lookahead ? boxPos + 1 : 0;
+
+    const float gain = juce::jmin(1.0f, (float)(boxSum * boxScale));
+    peaksToGains[i] = gain;
+    lowest = juce::jmin(lowest, gain);
+  }
+
+  // Lock-free minimum with whatever the UI hasn't read yet
+  float current = meterGain.load();
+  while (lowest < current &&
+         !meterGain.compare_exchange_weak(current, lowest)) {
+  }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "ParameterRamp.h"
+#include "ScratchArena.h"
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    The output stage: smoothed gain and constant-power pan folded into one
+    gain ramp per channel, then an optional lookahead limiter holding the
+    true peak under -1 dBTP.
+
+    Without the limiter that is a single multiply per channel. With it, the
+    gained input goes into a short delay line and a 4x interpolating
+    detector (three inter-sample phases, each a handful of vector
+    multiply-adds) finds the peaks the samples themselves miss. The gain
+    reduction is the minimum over the lookahead window, recovering
+    exponentially and then box-averaged over the window, so it is fully
+    down by the time a peak leaves the delay line. Only that envelope runs
+    sample by sample; applying it is one more multiply per channel.
+
+    The limiter adds its lookahead to the latency, so switching it is not
+    something to automate. The deepest reduction since the UI last asked
+    is kept in an atomic for the meter.
+*/
+class MasterStage {
+public:
+  static constexpr float ceilingDb = -1.0f;
+  static constexpr double lookaheadSeconds = 0.0015;
+  static constexpr double releaseSeconds = 0.1;
+
+  MasterStage();
+
+  void prepare(const juce::dsp::ProcessSpec &spec);
+  void reset();
+  void setScratchArena(ScratchArena *arena) { scratch = arena; }
+
+  // Gain is linear, pan -1..1 (cos/sin law, so -3 dB each side at centre)
+  void setGainAndPan(float gain, float pan);
+  // Clears the lookahead when it changes
+  void setLimiter(bool enabled);
+  bool isLimiterEnabled() const { return limiterEnabled; }
+
+  void process(juce::AudioBuffer<float> &buffer);
+
+  int getLatencySamples() const {
+    return limiterEnabled ? lookahead + detectorDelay : 0;
+  }
+
+  // UI thread: the deepest gain reduction since the last call, in dB (0 or
+  // less)
+  float popGainReductionDb();
+
+private:
+  // Interpolator taps either side of a detector point
+  static constexpr int tapsBefore = 5;
+  static constexpr int numTaps = 12;
+  static constexpr int numPhases = 3; // 1/4, 1/2 and 3/4 between samples
+  // The detector needs numTaps - tapsBefore - 1 samples past its point
+  static constexpr int detectorDelay = numTaps - tapsBefore - 1;
+
+  void processChunk(juce::AudioBuffer<float> &buffer, int start,
+                    int numSamples);
+  // Per-sample limiter gains from the block's detector peaks, in place
+  void computeGains(float *peaksToGains, int numSamples);
+  void clearLimiter();
+
+  ScratchArena *scratch = nullptr;
+
+  std::array<juce::LinearSmoothedValue<float>, 2> channelGain;
+  int numChannels = 2;
+  int maxBlockSize = 0;
+
+  bool limiterEnabled = false;
+  float ceiling = 1.0f;
+  float releaseCoefficient = 0.0f;
+  int lookahead = 1;
+
+  alignas(16) float interpolator[numPhases][numTaps] = {};
+
+  // Per channel: lookahead + detectorDelay samples of history, then room
+  // for a block
+  juce::AudioBuffer<float> line;
+  int history = 0;
+
+  // Sliding minimum of the required gain over lookahead + 1 steps, as a
+  // ring of increasing values with the step each arrived at
+  std::vector<float> minValues;
+  std::vector<juce::int64> minSteps;
+  int minMask = 0, minFront = 0, minCount = 0;
+  juce::int64 step = 0;
+
+  float envelope = 1.0f;
+  std::vector<float> box; // The last lookahead envelope values
+  double boxSum = 0.0;
+  int boxPos = 0;
+
+  // Lowest limiter gain since the UI last read it (1 = none)
+  std::atomic<float> meterGain{1.0f};
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MasterStage)
+};
@@ -0,0 +1,143 @@
+#include "MemoryLock.h"
+
+#if JUCE_WINDOWS
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace {
+using Address = juce::pointer_sized_uint;
+
+// Locks held on each pinned page, keyed by page address. Only the message
+// and loader threads lock and unlock, never the audio thread.
+juce::CriticalSection registryLock;
+std::map<Address, int> pageRefs;
+std::atomic<size_t> totalLockedBytes{0};
+
+Address getPageSize() {
+  static const auto pageSize =
+      (Address)juce::jmax(4096, juce::SystemStats::getPageSize());
+  return pageSize;
+}
+
+bool osLock(Address start, Address end) {
+#if JUCE_WINDOWS
+  return VirtualLock((void *)start, (SIZE_T)(end - start)) != 0;
+#else
+  return mlock((const void *)start, (size_t)(end - start)) == 0;
+#endif
+}
+
+void osUnlock(Address start, Address end) {
+#if JUCE_WINDOWS
+  VirtualUnlock((void *)start, (SIZE_T)(end - start));
+#else
+  munlock((const void *)start, (size_t)(end - start));
+#endif
+}
+
+// Calls fn(start, end) for each run of pages in [first, end) with no locks
+// held on them yet
+template <typename Fn>
+void forEachUnheldRun(Address first, Address end, Fn &&fn) {
+  const auto pageSize = getPageSize();
+  for (auto page = first; page < end;) {
+    if (pageRefs.count(page) != 0) {
+      page += pageSize;
+      continue;
+    }
+
+    auto runEnd = page + pageSize;
+    while (runEnd < end && pageRefs.count(runEnd) == 0)
+      runEnd += pageSize;
+
+    fn(page, runEnd);
+    page = runEnd;
+  }
+}
+} // namespace
+
+MemoryLock::MemoryLock(const void *data, size_t numBytes) {
+  if (data == nullptr || numBytes == 0)
+    return;
+
+  const auto pageSize = getPageSize();
+  const auto start = (Address)data;
+  pages = {start & ~(pageSize - 1),
+           (start + numBytes + pageSize - 1) & ~(pageSize - 1)};
+
+  {
+    const juce::ScopedLock sl(registryLock);
+
+    // Only pages nobody holds yet go to the OS; if any run fails, undo the
+    // ones this lock took
+    bool ok = true;
+    std::vector<PageRange> taken;
+    forEachUnheldRun(pages.getStart(), pages.getEnd(),
+                     [&](Address runStart, Address runEnd) {
+                       if (ok && osLock(runStart, runEnd))
+                         taken.push_back({runStart, runEnd});
+                       else
+                         ok = false;
+                     });
+
+    if (ok) {
+      for (auto page = pages.getStart(); page < pages.getEnd();
+           page += pageSize)
+        ++pageRefs[page];
+      totalLockedBytes = pageRefs.size() * (size_t)pageSize;
+      locked = true;
+      return;
+    }
+
+    for (const auto &run : taken)
+      osUnlock(run.getStart(), run.getEnd());
+  }
+
+  DBG("MemoryLock: could not lock " + juce::String((juce::int64)numBytes) +
+      " bytes, pre-faulting instead");
+
+  // Not pinned, but at least resident right now
+  const auto *bytes = static_cast<const volatile char *>(data);
+  for (size_t i = 0; i < numBytes; i += (size_t)pageSize)
+    (void)bytes[i];
+}
+
+MemoryLock::~MemoryLock() {
+  if (!locked)
+    return;
+
+  const juce::ScopedLock sl(registryLock);
+  const auto pageSize = getPageSize();
+
+  // Pages another lock still holds stay pinned
+  for (auto page = pages.getStart(); page < pages.getEnd(); page += pageSize) {
+    auto ref = pageRefs.find(page);
+    jassert(ref != pageRefs.end());
+    if (ref != pageRefs.end() && --ref->second == 0)
+      pageRefs.erase(ref);
+  }
+
+  forEachUnheldRun(pages.getStart(), pages.getEnd(), osUnlock);
+  totalLockedBytes = pageRefs.size() * (size_t)pageSize;
+}
+
+size_t MemoryLock::countUniqueBytes(std::vector<PageRange> ranges) {
+  std::sort(ranges.begin(), ranges.end(),
+            [](const PageRange &a, const PageRange &b) {
+              return a.getStart() < b.getStart();
+            });
+
+  size_t total = 0;
+  Address coveredTo = 0;
+  for (const auto &range : ranges) {
+    const auto start = juce::jmax(range.getStart(), coveredTo);
+    if (range.getEnd() > start)
+      total += (size_t)(range.getEnd() - start);
+    coveredTo = juce::jmax(coveredTo, range.getEnd());
+  }
+  return total;
+}
+
+size_t MemoryLock::getTotalLockedBytes() { return totalLockedBytes.load(); }
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_MSVC && JUCE_INTEL
+#include <xmmintrin.h>
+#endif
+
+//==============================================================================
+/**
+    Pins a range of memory in physical RAM (mlock / VirtualLock) so reading
+    it can never take a page fault, and unpins it again on destruction.
+
+    The OS locks whole pages, so the range is widened to page boundaries and
+    each page is reference counted across every MemoryLock in the process:
+    a page shared with a neighbouring range stays pinned until the last lock
+    on it goes. Locking can fail (e.g. RLIMIT_MEMLOCK); the pages are still
+    faulted in once, and isLocked() reports false.
+*/
+class MemoryLock {
+public:
+  // Page-aligned addresses, [start, end)
+  using PageRange = juce::Range<juce::pointer_sized_uint>;
+
+  MemoryLock(const void *data, size_t numBytes);
+  ~MemoryLock();
+
+  bool isLocked() const { return locked; }
+  // The pages this lock holds, empty if it isn't locked
+  PageRange getLockedPages() const { return locked ? pages : PageRange(); }
+  size_t getLockedBytes() const {
+    return (size_t)getLockedPages().getLength();
+  }
+
+  // Bytes in the given ranges, counting pages they share once
+  static size_t countUniqueBytes(std::vector<PageRange> ranges);
+
+  // Bytes currently pinned by all MemoryLocks in the process
+  static size_t getTotalLockedBytes();
+
+private:
+  PageRange pages;
+  bool locked = false;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MemoryLock)
+};
+
+// Software prefetch hint for data about to be read (no-op where unsupported)
+inline void prefetchForRead(const void *address) {
+#if JUCE_GCC || JUCE_CLANG
+  __builtin_prefetch(address, 0, 3);
+#elif JUCE_MSVC && JUCE_INTEL
+  _mm_prefetch((const char *)address, _MM_HINT_T0);
+#else
+  juce::ignoreUnused(address);
+#endif
+}
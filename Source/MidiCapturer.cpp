@@ -1,114 +1,184 @@
 #include "MidiCapturer.h"
 
-MidiCapturer::MidiCapturer() {}
+namespace {
+// How often the background thread empties the ring while recording
+constexpr int drainIntervalMs = 50;
+} // namespace
 
-MidiCapturer::~MidiCapturer() {}
+MidiCapturer::MidiCapturer() : juce::Thread("MIDI Capture") {
+  ring.resize((size_t)ringSize);
+}
+
+MidiCapturer::~MidiCapturer() {
+  signalThreadShouldExit();
+  notify();
+  stopThread(1000);
+}
+
+void MidiCapturer::prepare(double sr) {
+  sampleRate = sr;
 
-void MidiCapturer::prepare(double sr) { sampleRate = sr; }
+  if (!isThreadRunning())
+    startThread(juce::Thread::Priority::low);
+}
 
-void MidiCapturer::processMidi(const juce::MidiBuffer &buffer, int numSamples) {
+void MidiCapturer::processMidi(const juce::MidiBuffer &buffer, int numSamples,
+                               juce::AudioPlayHead *playHead) {
   if (!recording.load())
     return;
 
-  // We are on Audio Thread! Use lock.
-  const juce::ScopedLock sl(lock);
+  double bpm = 120.0;
+  juce::Optional<double> hostPpq, barStart;
+  bool hostPlaying = false;
+  if (playHead != nullptr) {
+    if (auto position = playHead->getPosition()) {
+      if (position->getBpm().hasValue() && *position->getBpm() > 0.0)
+        bpm = *position->getBpm();
+      hostPpq = position->getPpqPosition();
+      barStart = position->getPpqPositionOfLastBarStart();
+      hostPlaying = position->getIsPlaying();
+    }
+  }
+
+  // A new take starts the clock over: from its bar line when the host is
+  // playing, so the file sits on the DAW's grid
+  const int take = currentTake.load();
+  if (take != audioTake) {
+    audioTake = take;
+    takeBeats = 0.0;
+    takeBpm = 0.0;
+    if (hostPlaying && hostPpq.hasValue())
+      takeBeats = juce::jmax(0.0, *hostPpq - barStart.orFallback(
+                                                 std::floor(*hostPpq)));
+  }
+
+  if (bpm != takeBpm) {
+    // The take's first tempo goes at tick 0, so the lead-in to the first
+    // note plays at it too; later changes land where they happen
+    CapturedEvent tempo;
+    tempo.beats = takeBpm > 0.0 ? takeBeats : 0.0;
+    takeBpm = bpm;
+    tempo.bpm = bpm;
+    tempo.take = take;
+    push(tempo);
+  }
+
+  const double beatsPerSample = bpm / (60.0 * sampleRate.load());
 
   for (const auto metadata : buffer) {
-    auto message = metadata.getMessage();
+    // Short messages only (notes, CCs, bends); sysex isn't worth a
+    // variable-size ring
+    if (metadata.numBytes <= 0 || metadata.numBytes > 3)
+      continue;
+
+    CapturedEvent event;
+    event.beats = takeBeats + metadata.samplePosition * beatsPerSample;
+    event.take = take;
+    std::memcpy(event.data, metadata.data, (size_t)metadata.numBytes);
+    event.size = (juce::uint8)metadata.numBytes;
+    push(event);
+  }
 
-    // We typically only Capture NoteOn/NoteOff for drag and drop
-    // but CC is fine too.
+  // The tempo holds for the block
+  takeBeats += numSamples * beatsPerSample;
+  takeEndBeats = takeBeats;
+}
+
+bool MidiCapturer::push(const CapturedEvent &event) {
+  int start1, size1, start2, size2;
+  fifo.prepareToWrite(1, start1, size1, start2, size2);
+  if (size1 + size2 == 0) {
+    // Full: the drain thread has fallen far behind. Lose the event, not
+    // the block.
+    droppedEvents.fetch_add(1);
+    return false;
+  }
 
-    // Calculate relative time from start of recording
-    // Since processMidi is called continuously, we need a running clock?
-    // Actually, simple way: we append messages with their sample timestamp
-    // relative to the BLOCK. BUT MidiMessageSequence needs absolute time
-    // (seconds or ticks).
+  ring[(size_t)(size1 > 0 ? start1 : start2)] = event;
+  fifo.finishedWrite(1);
+  return true;
+}
 
-    // Wait. "The Audio Programmer" pattern:
-    // We just keep adding 'message.getTimeStamp()' which is sample offset in
-    // buffer? No, we need to accumulate time.
+void MidiCapturer::run() {
+  while (!threadShouldExit()) {
+    // Asleep until a take starts, then on a short interval
+    wait(recording.load() ? drainIntervalMs : -1);
 
-    message.setTimeStamp(startTime + (metadata.samplePosition / sampleRate));
-    midiSequence.addEvent(message);
+    const juce::ScopedLock sl(fileLock);
+    drain();
   }
+}
+
+void MidiCapturer::drain() {
+  const int take = currentTake.load();
+
+  int start1, size1, start2, size2;
+  fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+  auto write = [&](int start, int size) {
+    for (int i = 0; i < size; ++i) {
+      const auto &event = ring[(size_t)(start + i)];
+      if (event.take != take)
+        continue; // Left over from a stopped take
 
-  // Advance global time
-  startTime += numSamples / sampleRate;
+      if (event.size == 0)
+        writer.addTempo(event.beats, event.bpm);
+      else
+        writer.addEvent(event.beats, event.data, event.size);
+    }
+  };
+
+  write(start1, size1);
+  write(start2, size2);
+  fifo.finishedRead(size1 + size2);
 }
 
 void MidiCapturer::startRecording() {
-  const juce::ScopedLock sl(lock);
-  midiSequence.clear();
-  startTime = 0.0;
+  const juce::ScopedLock sl(fileLock);
+
+  // Bumping the take first makes the drain drop anything left from the
+  // last one
+  currentTake.fetch_add(1);
+  drain();
+  droppedEvents = 0;
+  takeEndBeats = 0.0;
+
+  // A fresh file per take; the last one may still be on its way into the
+  // DAW, so it is only deleted when the next one is finished
+  writer.close(0.0);
+  takeFile = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                 .getNonexistentChildFile("WolfMidiCapture", ".mid", false);
+  writer.open(takeFile);
+
   recording.store(true);
+  notify();
 }
 
 void MidiCapturer::stopRecording() {
   recording.store(false);
-  // Post-process: Ensure NoteOffs?
-  // juce::MidiMessageSequence usually handles sorting.
-
-  midiSequence.updateMatchedPairs();
-
-  // We should create the file immediately or wait for UI request?
-  // Let's just hold the sequence.
-}
 
-bool MidiCapturer::isRecording() const { return recording.load(); }
+  // Whatever the drain thread hasn't picked up yet, then the file is done
+  const juce::ScopedLock sl(fileLock);
+  drain();
+  if (!writer.isOpen())
+    return;
 
-bool MidiCapturer::hasRecording() const {
-  return midiSequence.getNumEvents() > 0;
-}
+  const bool hasEvents = writer.getNumEvents() > 0;
+  writer.close(takeEndBeats.load());
 
-juce::File MidiCapturer::saveToTempFile() {
-  const juce::ScopedLock sl(lock);
-  if (midiSequence.getNumEvents() == 0)
-    return {};
-
-  // Create a temp file
-  auto file = juce::File::getSpecialLocation(juce::File::tempDirectory)
-                  .getChildFile("WolfMidiCapture.mid");
-
-  if (file.existsAsFile())
-    file.deleteFile();
-
-  juce::MidiFile midiFile;
-  midiFile.setTicksPerQuarterNote(960); // Standard resolution
-
-  // Convert seconds to ticks?
-  // JUCE MidiFile can write tracks based on Seconds if we tell it?
-  // Actually, addTrack takes a MidiMessageSequence.
-  // By default it expects timestamp in Seconds? "The timestamp of the messages
-  // in the sequence are treated as being in seconds" if we don't specify
-  // otherwise? Checking docs: "If the MidiFile's time format is set to
-  // timestamps in seconds ... otherwise ticks" It defaults to ticks.
-
-  // We recorded in Seconds. We need to convert or set format.
-  // MidiFile doesn't support "Seconds" mode for writing standard MIDI files
-  // universally compatible. Standard MIDI files use Ticks. So we assume a tempo
-  // (e.g. 120 BPM) and convert seconds to ticks.
-
-  juce::MidiMessageSequence ticksSequence;
-  double bpm = 120.0; // Assume 120 for drag-drop (most DAWs auto-stretch or
-                      // just place it)
-  double ticksPerSecond = (960.0 * bpm) / 60.0;
-
-  for (int i = 0; i < midiSequence.getNumEvents(); ++i) {
-    auto msg = midiSequence.getEventPointer(i)->message;
-    double seconds = msg.getTimeStamp();
-    double ticks = seconds * ticksPerSecond;
-    msg.setTimeStamp(ticks);
-    ticksSequence.addEvent(msg);
+  if (!hasEvents) {
+    takeFile.deleteFile();
+    return;
   }
-  ticksSequence.updateMatchedPairs();
 
-  midiFile.addTrack(ticksSequence);
+  if (lastFile != juce::File())
+    lastFile.deleteFile();
+  lastFile = takeFile;
+}
 
-  if (auto outStream = file.createOutputStream()) {
-    midiFile.writeTo(*outStream);
-    outStream->flush();
-  }
+bool MidiCapturer::isRecording() const { return recording.load(); }
 
-  return file;
+juce::File MidiCapturer::getLastRecording() const {
+  const juce::ScopedLock sl(fileLock);
+  return lastFile;
 }
@@ -1,32 +1,91 @@
 #pragma once
 
+#include "MidiFileWriter.h"
 #include <JuceHeader.h>
 #include <atomic>
 
-class MidiCapturer {
+//==============================================================================
+/**
+    Records the MIDI going into the synth for drag and drop.
+
+    The audio thread only copies each short message and its time into a
+    preallocated single-producer ring; it never locks or allocates. Times
+    are in quarter notes, integrated from the host tempo block by block and
+    starting from the bar the take began in when the host is playing, so
+    the file lines up with the DAW grid at any tempo (and keeps counting
+    through a loop rather than jumping back). Tempo changes go through the
+    ring too.
+
+    A background thread drains the ring straight into a .mid file on disk
+    every few tens of milliseconds, so a recording can run for as long as
+    it likes without growing in memory. Stopping drains what is left and
+    finishes the file; dragging just hands that file over.
+
+    Events carry the take they were recorded in, so anything still in the
+    ring from a stopped take is dropped when the next one starts.
+*/
+class MidiCapturer : private juce::Thread {
 public:
+  // Events the ring holds between drains (several seconds of dense MIDI)
+  static constexpr int ringSize = 8192;
+
   MidiCapturer();
-  ~MidiCapturer();
+  ~MidiCapturer() override;
 
   void prepare(double sampleRate);
-  void processMidi(const juce::MidiBuffer &buffer, int numSamples);
+  // Audio thread. The play head may be null (then 120 BPM, free running).
+  void processMidi(const juce::MidiBuffer &buffer, int numSamples,
+                   juce::AudioPlayHead *playHead);
 
   void startRecording();
   void stopRecording();
   bool isRecording() const;
 
+  // The finished .mid file of the last take that had any events (a take in
+  // progress doesn't count until it stops)
   juce::File getLastRecording() const;
-  bool hasRecording() const;
+  bool hasRecording() const { return getLastRecording() != juce::File(); }
 
-  // Creates the .mid file and returns it
-  juce::File saveToTempFile();
+  // Events lost to a full ring since recording started
+  int getDroppedEvents() const { return droppedEvents.load(); }
 
 private:
+  // One short message, or a tempo change (size 0), at a time in quarter
+  // notes from the start of its take
+  struct CapturedEvent {
+    double beats = 0.0;
+    double bpm = 0.0;
+    int take = 0;
+    juce::uint8 data[3] = {};
+    juce::uint8 size = 0;
+  };
+
+  void run() override;
+  // Audio thread. False (and counted) if the ring is full.
+  bool push(const CapturedEvent &event);
+  // Consumer side of the ring; callers hold fileLock
+  void drain();
+
   std::atomic<bool> recording{false};
-  juce::MidiMessageSequence midiSequence;
-  double sampleRate = 44100.0;
-  double startTime = 0.0;
+  std::atomic<int> currentTake{0};
+  std::atomic<double> sampleRate{44100.0};
+  std::atomic<int> droppedEvents{0};
+
+  // Where the audio thread's clock was at the end of the last block, for
+  // the end of the file
+  std::atomic<double> takeEndBeats{0.0};
+
+  // Audio thread only
+  int audioTake = 0;
+  double takeBeats = 0.0; // At the start of the current block
+  double takeBpm = 0.0;   // Last tempo written
+
+  juce::AbstractFifo fifo{ringSize};
+  std::vector<CapturedEvent> ring;
 
-  juce::CriticalSection lock; // Protect sequence access
-  juce::File lastFile;
+  // Between the drain thread and the UI, never the audio thread
+  mutable juce::CriticalSection fileLock;
+  MidiFileWriter writer;
+  juce::File takeFile; // Being written
+  juce::File lastFile; // Finished
 };
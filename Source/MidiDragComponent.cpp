@@ -62,13 +62,11 @@ void MidiDragComponent::mouseDrag(const juce::MouseEvent &e) {
   if (isRecording)
     return;
 
-  auto &capturer = audioProcessor.getMidiCapturer();
-  if (capturer.hasRecording()) {
-    auto file = capturer.saveToTempFile();
-    if (file.existsAsFile()) {
-      juce::StringArray files;
-      files.add(file.getFullPathName());
-      performExternalDragDropOfFiles(files, true);
-    }
+  // Already written and closed when the recording stopped
+  auto file = audioProcessor.getMidiCapturer().getLastRecording();
+  if (file.existsAsFile()) {
+    juce::StringArray files;
+    files.add(file.getFullPathName());
+    performExternalDragDropOfFiles(files, true);
   }
 }
@@ -0,0 +1,116 @@
+#include "MidiFileWriter.h"
+
+bool MidiFileWriter::open(const juce::File &file) {
+  close(0.0);
+
+  auto newStream = std::make_unique<juce::FileOutputStream>(file);
+  if (!newStream->openedOk())
+    return false;
+
+  newStream->setPosition(0);
+  newStream->truncate();
+  stream = std::move(newStream);
+
+  // Header: format 0, one track, ticks per quarter note
+  stream->write("MThd", 4);
+  stream->writeIntBigEndian(6);
+  stream->writeShortBigEndian(0);
+  stream->writeShortBigEndian(1);
+  stream->writeShortBigEndian((short)ticksPerQuarterNote);
+
+  // The track, its length filled in on close
+  stream->write("MTrk", 4);
+  lengthPosition = stream->getPosition();
+  stream->writeIntBigEndian(0);
+  trackStart = stream->getPosition();
+
+  lastTick = 0;
+  numEvents = 0;
+  heldNotes.reset();
+  return true;
+}
+
+void MidiFileWriter::addTempo(double beats, double bpm) {
+  if (stream == nullptr || bpm <= 0.0)
+    return;
+
+  // Set Tempo meta event: microseconds per quarter note, 24 bits
+  const auto micros = (juce::uint32)juce::jlimit(
+      1.0, (double)0xffffff, std::round(60000000.0 / bpm));
+  const juce::uint8 meta[] = {0xff,
+                              0x51,
+                              0x03,
+                              (juce::uint8)(micros >> 16),
+                              (juce::uint8)(micros >> 8),
+                              (juce::uint8)micros};
+  writeDelta(beats);
+  stream->write(meta, sizeof(meta));
+}
+
+void MidiFileWriter::addEvent(double beats, const juce::uint8 *data,
+                              int numBytes) {
+  if (stream == nullptr || numBytes <= 0 || numBytes > 3 || data[0] < 0x80 ||
+      data[0] >= 0xf0 ||
+      juce::MidiMessage::getMessageLengthFromFirstByte(data[0]) != numBytes)
+    return;
+
+  const int channel = data[0] & 0x0f;
+  const int type = data[0] & 0xf0;
+  if (type == 0x90 || type == 0x80) {
+    const bool on = type == 0x90 && data[2] > 0;
+    heldNotes.set((size_t)(channel * 128 + (data[1] & 0x7f)), on);
+  }
+
+  writeDelta(beats);
+  stream->write(data, (size_t)numBytes);
+  ++numEvents;
+}
+
+void MidiFileWriter::close(double endBeats) {
+  if (stream == nullptr)
+    return;
+
+  // Anything still down ends with the recording
+  for (size_t i = 0; i < heldNotes.size(); ++i) {
+    if (!heldNotes[i])
+      continue;
+
+    const juce::uint8 noteOff[] = {(juce::uint8)(0x80 | (i / 128)),
+                                   (juce::uint8)(i % 128), 0};
+    writeDelta(endBeats);
+    stream->write(noteOff, sizeof(noteOff));
+  }
+  heldNotes.reset();
+
+  const juce::uint8 endOfTrack[] = {0xff, 0x2f, 0x00};
+  writeDelta(endBeats);
+  stream->write(endOfTrack, sizeof(endOfTrack));
+
+  const auto end = stream->getPosition();
+  stream->setPosition(lengthPosition);
+  stream->writeIntBigEndian((int)(end - trackStart));
+  stream->flush();
+  stream.reset();
+}
+
+void MidiFileWriter::writeDelta(double beats) {
+  const auto tick = juce::jmax(
+      lastTick, (juce::int64)std::llround(beats * ticksPerQuarterNote));
+  // Deltas are at most 28 bits
+  writeVariableLength(
+      (juce::uint32)juce::jmin<juce::int64>(tick - lastTick, 0x0fffffff));
+  lastTick = tick;
+}
+
+void MidiFileWriter::writeVariableLength(juce::uint32 value) {
+  // Seven bits a byte, most significant first, continuation bit on all but
+  // the last
+  juce::uint8 bytes[4];
+  int numBytes = 0;
+  bytes[numBytes++] = (juce::uint8)(value & 0x7f);
+  while ((value >>= 7) != 0)
+    bytes[numBytes++] = (juce::uint8)((value & 0x7f) | 0x80);
+
+  while (numBytes > 0)
+    stream->writeByte((char)bytes[--numBytes]);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Writes a single-track Standard MIDI File to disk as events arrive, so
+    a recording never has to be held in memory. Times are in quarter notes
+    from the start of the file; ticks never go backwards (anything earlier
+    than the last event lands on it).
+
+    The track length is patched into the header on close(), which also
+    ends any notes still held. Not thread safe: one writer at a time.
+*/
+class MidiFileWriter {
+public:
+  static constexpr int ticksPerQuarterNote = 960;
+
+  MidiFileWriter() = default;
+  ~MidiFileWriter() { close(0.0); }
+
+  // Replaces the file. False if it can't be written.
+  bool open(const juce::File &file);
+  bool isOpen() const { return stream != nullptr; }
+
+  void addTempo(double beats, double bpm);
+  // One short channel message (1 to 3 bytes)
+  void addEvent(double beats, const juce::uint8 *data, int numBytes);
+
+  // Note-offs for held notes and the end of track at endBeats (or the
+  // last event, if later), then the header fix-up
+  void close(double endBeats);
+
+  int getNumEvents() const { return numEvents; }
+
+private:
+  void writeDelta(double beats);
+  void writeVariableLength(juce::uint32 value);
+
+  std::unique_ptr<juce::FileOutputStream> stream;
+  juce::int64 lengthPosition = 0; // The track chunk's length field
+  juce::int64 trackStart = 0;
+  juce::int64 lastTick = 0;
+  int numEvents = 0;
+
+  // Per channel and note, so close() can end them
+  std::bitset<16 * 128> heldNotes;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiFileWriter)
+};
@@ -6,7 +6,14 @@
 
 Arpeggiator::Arpeggiator() {}
 
-void Arpeggiator::prepare(double sampleRate) { currentSampleRate = sampleRate; }
+void Arpeggiator::prepare(double sampleRate) {
+  currentSampleRate = sampleRate;
+
+  // At most one entry per MIDI note
+  sortedNotes.reserve(128);
+  activeNotes.reserve(128);
+  processedMidi.ensureSize(midiScratchBytes);
+}
 
 void Arpeggiator::reset() {
   sortedNotes.clear();
@@ -166,9 +173,9 @@ void Arpeggiator::process(juce::MidiBuffer &midiMessages, int numSamples,
 
   // --- 3. If ENABLED: Filter Input & Generate Arp ---
 
-  // Create a clean buffer. We will populate it with everything EXCEPT input
-  // notes.
-  juce::MidiBuffer processedMidi;
+  // Start from a clean buffer. We will populate it with everything EXCEPT
+  // input notes.
+  processedMidi.clear();
 
   for (const auto metadata : midiMessages) {
     auto msg = metadata.getMessage();
@@ -193,7 +200,9 @@ void Arpeggiator::process(juce::MidiBuffer &midiMessages, int numSamples,
 
   // Generate Arp Notes
   if (sortedNotes.empty()) {
-    midiMessages.swapWith(processedMidi); // Output clean buffer (silence)
+    // Output clean buffer (silence)
+    midiMessages.clear();
+    midiMessages.addEvents(processedMidi, 0, -1, 0);
     return;
   }
 
@@ -242,8 +251,10 @@ void Arpeggiator::process(juce::MidiBuffer &midiMessages, int numSamples,
     currentSamplePos += processAmount;
   }
 
-  // Final Swap
-  midiMessages.swapWith(processedMidi);
+  // Copied back rather than swapped, so the storage sized in prepare stays
+  // here
+  midiMessages.clear();
+  midiMessages.addEvents(processedMidi, 0, -1, 0);
 }
 
 //==============================================================================
@@ -252,13 +263,17 @@ void Arpeggiator::process(juce::MidiBuffer &midiMessages, int numSamples,
 
 ChordEngine::ChordEngine() {}
 
+void ChordEngine::prepare() {
+  processedBuf.ensureSize(Arpeggiator::midiScratchBytes);
+}
+
 void ChordEngine::setParameters(int mode, int keys) { chordMode = mode; }
 
 void ChordEngine::process(juce::MidiBuffer &midiMessages) {
   if (chordMode == 0)
     return; // Off
 
-  juce::MidiBuffer processedBuf;
+  processedBuf.clear();
 
   for (const auto metadata : midiMessages) {
     auto msg = metadata.getMessage();
@@ -308,7 +323,8 @@ void ChordEngine::process(juce::MidiBuffer &midiMessages) {
     }
   }
 
-  midiMessages.swapWith(processedBuf);
+  midiMessages.clear();
+  midiMessages.addEvents(processedBuf, 0, -1, 0);
 }
 
 //==============================================================================
@@ -320,6 +336,7 @@ MidiProcessor::MidiProcessor() {}
 void MidiProcessor::prepare(double sampleRate) {
   currentSampleRate = sampleRate;
   arp.prepare(sampleRate);
+  chordEngine.prepare();
 }
 
 void MidiProcessor::reset() { arp.reset(); }
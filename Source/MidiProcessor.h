@@ -7,6 +7,9 @@
 //==============================================================================
 class Arpeggiator {
 public:
+  // Bytes reserved for each stage's output MIDI (a few hundred events)
+  static constexpr int midiScratchBytes = 4096;
+
   Arpeggiator();
   ~Arpeggiator() = default;
 
@@ -33,6 +36,11 @@ private:
   };
   std::vector<ActiveNote> activeNotes;
 
+  // Output is built here and copied back into the host buffer. Sized in
+  // prepare and only ever cleared, so the audio thread never allocates for
+  // it (swapping would hand the storage to the host).
+  juce::MidiBuffer processedMidi;
+
   // Params
   bool enabled = false;
   float rateDiv = 1.0f; // 1 = quarter note? No, standard divisions.
@@ -55,6 +63,7 @@ public:
   ChordEngine();
   ~ChordEngine() = default;
 
+  void prepare();
   void process(juce::MidiBuffer &midiMessages);
 
   // Parameters
@@ -62,6 +71,7 @@ public:
 
 private:
   int chordMode = 0;
+  juce::MidiBuffer processedBuf; // Preallocated, see Arpeggiator
   // Temporary storage for generated notes to ensure NoteOffs match
   // For v1, we transform NoteOn(C) -> NoteOn(C, E, G).
   // And NoteOff(C) -> NoteOff(C, E, G).
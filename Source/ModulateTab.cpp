@@ -23,11 +23,23 @@ ModulateTab::ModulateTab(HowlingWolvesAudioProcessor &p) : audioProcessor(p) {
   setupKnob(resSlider, "Res", resAttachment, "filterRes");
   resSlider.setTooltip("Sets the filter resonance (Q factor).");
 
+  setupKnob(envCutoffSlider, "Env", envCutoffAttachment, "envCutoff");
+  envCutoffSlider.setTooltip(
+      "How far the amp envelope moves the cutoff (up or down).");
+
+  setupKnob(velCutoffSlider, "Vel", velCutoffAttachment, "velCutoff");
+  velCutoffSlider.setTooltip("Opens the cutoff with harder key velocity.");
+
+  setupKnob(vowelSlider, "Vowel", vowelAttachment, "filterVowel");
+  vowelSlider.setTooltip(
+      "Formant filter only: sweeps the vowel from A through E, I and O to U.");
+
   addAndMakeVisible(filterTypeBox);
   filterTypeBox.addItem("Low Pass", 1);
   filterTypeBox.addItem("High Pass", 2);
   filterTypeBox.addItem("Band Pass", 3);
   filterTypeBox.addItem("Notch", 4);
+  filterTypeBox.addItem("Formant", 5);
   filterTypeBox.setJustificationType(juce::Justification::centred);
   filterTypeBox.setTooltip("Selects the filter type.");
 
@@ -37,6 +49,20 @@ ModulateTab::ModulateTab(HowlingWolvesAudioProcessor &p) : audioProcessor(p) {
         audioProcessor.getAPVTS(), "filterType", filterTypeBox);
   }
 
+  addAndMakeVisible(engineModeBox);
+  engineModeBox.addItem("Poly", 1);
+  engineModeBox.addItem("Paraphonic", 2);
+  engineModeBox.setJustificationType(juce::Justification::centred);
+  engineModeBox.setTooltip(
+      "Poly: filter per voice. Paraphonic: one shared filter, envelope and "
+      "LFO for all voices.");
+
+  if (audioProcessor.getAPVTS().getParameter("engineMode") != nullptr) {
+    engineModeAttachment = std::make_unique<
+        juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getAPVTS(), "engineMode", engineModeBox);
+  }
+
   // --- LFO Section ---
   addAndMakeVisible(lfoLabel);
   lfoLabel.setText("LFO", juce::dontSendNotification);
@@ -75,6 +101,17 @@ ModulateTab::ModulateTab(HowlingWolvesAudioProcessor &p) : audioProcessor(p) {
         juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
         audioProcessor.getAPVTS(), "lfoTarget", lfoTargetBox);
   }
+
+  addAndMakeVisible(lfoRetrigToggle);
+  lfoRetrigToggle.setTooltip(
+      "On: each note restarts its own LFO. Off: one LFO shared by all "
+      "voices.");
+
+  if (audioProcessor.getAPVTS().getParameter("lfoRetrigger") != nullptr) {
+    lfoRetrigAttachment =
+        std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+            audioProcessor.getAPVTS(), "lfoRetrigger", lfoRetrigToggle);
+  }
 }
 
 ModulateTab::~ModulateTab() {
@@ -148,13 +185,30 @@ void ModulateTab::resized() {
   filterControls.items.add(
       juce::FlexItem(resSlider).withWidth(50).withHeight(50).withMargin(
           {0, 0, 0, 20})); // Small Knob
+  filterControls.items.add(
+      juce::FlexItem(envCutoffSlider).withWidth(40).withHeight(40).withMargin(
+          {0, 0, 0, 10}));
+  filterControls.items.add(
+      juce::FlexItem(velCutoffSlider).withWidth(40).withHeight(40).withMargin(
+          {0, 0, 0, 10}));
+  filterControls.items.add(
+      juce::FlexItem(vowelSlider).withWidth(40).withHeight(40).withMargin(
+          {0, 0, 0, 10}));
 
   filterLayout.items.add(juce::FlexItem(filterControls).withFlex(1));
-  filterLayout.items.add(juce::FlexItem(filterTypeBox)
-                             .withHeight(25)
-                             .withWidth(100)
-                             .withMargin({0, 0, 10, 0})
-                             .withAlignSelf(juce::FlexItem::AlignSelf::center));
+
+  juce::FlexBox filterOptions;
+  filterOptions.justifyContent = juce::FlexBox::JustifyContent::center;
+  filterOptions.items.add(juce::FlexItem(filterTypeBox)
+                              .withHeight(25)
+                              .withWidth(100)
+                              .withMargin({0, 5, 10, 0}));
+  filterOptions.items.add(juce::FlexItem(engineModeBox)
+                              .withHeight(25)
+                              .withWidth(100)
+                              .withMargin({0, 0, 10, 5}));
+
+  filterLayout.items.add(juce::FlexItem(filterOptions).withHeight(40));
 
   filterLayout.performLayout(filterArea);
 
@@ -187,6 +241,10 @@ void ModulateTab::resized() {
                            .withHeight(25)
                            .withWidth(80)
                            .withMargin({0, 0, 10, 5}));
+  lfoOptions.items.add(juce::FlexItem(lfoRetrigToggle)
+                           .withHeight(25)
+                           .withWidth(70)
+                           .withMargin({0, 0, 10, 5}));
 
   lfoLayout.items.add(juce::FlexItem(lfoOptions).withHeight(40));
 
@@ -22,22 +22,27 @@ private:
 
   // Filter Section
   juce::GroupComponent filterGroup;
-  juce::Slider cutoffSlider, resSlider;
-  juce::ComboBox filterTypeBox;
+  juce::Slider cutoffSlider, resSlider, envCutoffSlider, velCutoffSlider,
+      vowelSlider;
+  juce::ComboBox filterTypeBox, engineModeBox;
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
-      cutoffAttachment, resAttachment;
+      cutoffAttachment, resAttachment, envCutoffAttachment,
+      velCutoffAttachment, vowelAttachment;
   std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
-      filterTypeAttachment;
+      filterTypeAttachment, engineModeAttachment;
   juce::Label filterLabel;
 
   // LFO Section
   juce::GroupComponent lfoGroup;
   juce::Slider lfoRateSlider, lfoDepthSlider;
   juce::ComboBox lfoWaveBox, lfoTargetBox;
+  juce::ToggleButton lfoRetrigToggle{"Retrig"};
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
       lfoRateAttachment, lfoDepthAttachment;
   std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
       lfoWaveAttachment, lfoTargetAttachment;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment>
+      lfoRetrigAttachment;
   juce::Label lfoLabel;
 
   // Helper to setup knobs
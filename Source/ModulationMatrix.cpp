@@ -0,0 +1,68 @@
+#include "ModulationMatrix.h"
+
+static float getDestinationRange(ModulationMatrix::Destination destination) {
+  switch (destination) {
+  case ModulationMatrix::Destination::Cutoff:
+    return ModulationMatrix::cutoffOctaves;
+  case ModulationMatrix::Destination::Gain:
+    return ModulationMatrix::gainRange;
+  case ModulationMatrix::Destination::Pan:
+    return ModulationMatrix::panRange;
+  case ModulationMatrix::Destination::Pitch:
+    return ModulationMatrix::pitchSemitones;
+  }
+  return 0.0f;
+}
+
+void ModulationMatrix::setSlot(int index, Source source,
+                               Destination destination, float amount) {
+  jassert(index >= 0 && index < maxSlots);
+  auto &slot = slots[(size_t)index];
+
+  if (slot.source == source && slot.destination == destination &&
+      slot.amount == amount)
+    return;
+
+  slot = {source, destination, amount};
+  dirty = true;
+}
+
+void ModulationMatrix::compile() {
+  if (!dirty)
+    return;
+
+  numOps = 0;
+  destinationMask = 0;
+
+  for (const auto &slot : slots) {
+    if (slot.amount == 0.0f)
+      continue;
+
+    ops[(size_t)numOps++] = {(int)slot.source, (int)slot.destination,
+                             slot.amount *
+                                 getDestinationRange(slot.destination)};
+    destinationMask |= bit(slot.destination);
+  }
+
+  dirty = false;
+}
+
+void ModulationMatrix::process(const float *sources,
+                               float *destinations) const {
+  for (int d = 0; d < numDestinations; ++d)
+    destinations[d] = 0.0f;
+
+  for (int i = 0; i < numOps; ++i) {
+    const auto &op = ops[(size_t)i];
+    destinations[op.destination] += sources[op.source] * op.scale;
+  }
+}
+
+bool ModulationMatrix::feeds(Source source, int mask) const {
+  for (int i = 0; i < numOps; ++i) {
+    const auto &op = ops[(size_t)i];
+    if (op.source == (int)source && (mask & (1 << op.destination)) != 0)
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Routes modulation sources (LFO, envelope, velocity) to voice destinations
+    (cutoff, gain, pan, pitch).
+    Slots are only re-read when the routing changes: compile() flattens the
+    active ones into a short list of multiply-adds with the destination
+    scaling folded in, so an empty slot costs nothing when evaluating.
+    Voices evaluate it every controlInterval samples and interpolate.
+*/
+class ModulationMatrix {
+public:
+  enum class Source { Lfo = 0, Envelope, Velocity };
+  enum class Destination { Cutoff = 0, Gain, Pan, Pitch };
+
+  static constexpr int numSources = 3;
+  static constexpr int numDestinations = 4;
+  static constexpr int maxSlots = 8;
+  static constexpr int controlInterval = 32;
+
+  // What a modulation value of 1.0 means at each destination
+  static constexpr float cutoffOctaves = 2.0f;
+  static constexpr float gainRange = 0.5f;
+  static constexpr float panRange = 1.0f;
+  static constexpr float pitchSemitones = 12.0f;
+
+  ModulationMatrix() = default;
+
+  // amount of 0 disables the slot
+  void setSlot(int index, Source source, Destination destination,
+               float amount);
+
+  // Rebuilds the operation list if any slot changed since the last call
+  void compile();
+
+  // destinations[d] = sum of source * amount * range for every active slot
+  // (octaves, gain offset, pan offset and semitones respectively)
+  void process(const float *sources, float *destinations) const;
+
+  // Bit per destination with at least one active slot
+  int getDestinationMask() const { return destinationMask; }
+  // True if the source drives any of the destinations in mask
+  bool feeds(Source source, int mask) const;
+
+  static int bit(Destination destination) { return 1 << (int)destination; }
+
+private:
+  struct Slot {
+    Source source = Source::Lfo;
+    Destination destination = Destination::Cutoff;
+    float amount = 0.0f;
+  };
+
+  struct Op {
+    int source;
+    int destination;
+    float scale;
+  };
+
+  std::array<Slot, maxSlots> slots;
+  bool dirty = false;
+
+  std::array<Op, maxSlots> ops;
+  int numOps = 0;
+  int destinationMask = 0;
+
+  JUCE_LEAK_DETECTOR(ModulationMatrix)
+};
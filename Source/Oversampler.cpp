@@ -0,0 +1,125 @@
+#include "Oversampler.h"
+
+void Oversampler::prepare(const juce::dsp::ProcessSpec &spec) {
+  using OS = juce::dsp::Oversampling<float>;
+  maxLatency = 0;
+
+  for (size_t kind = 0; kind < stages.size(); ++kind) {
+    const auto type = kind == (size_t)Filter::PolyphaseIIR
+                          ? OS::filterHalfBandPolyphaseIIR
+                          : OS::filterHalfBandFIREquiripple;
+
+    for (int i = 0; i < maxOrder; ++i) {
+      // Integer latency so the bypass delay can match it exactly
+      auto &stage = stages[kind][(size_t)i];
+      stage = std::make_unique<OS>(spec.numChannels, (size_t)i + 1, type,
+                                   true, true);
+      stage->initProcessing(spec.maximumBlockSize);
+      maxLatency = juce::jmax(
+          maxLatency, juce::roundToInt(stage->getLatencyInSamples()));
+    }
+  }
+
+  history.setSize((int)spec.numChannels, juce::jmax(1, maxLatency));
+  fade.setSize((int)spec.numChannels, (int)spec.maximumBlockSize);
+  fadeStep = (float)(1.0 / (0.005 * spec.sampleRate)); // 5 ms
+
+  // Re-applies the current quality against the new stages
+  const int currentOrder = order;
+  order = -1;
+  setQuality(currentOrder, filter);
+}
+
+void Oversampler::reset() {
+  for (auto &kind : stages)
+    for (auto &stage : kind)
+      if (stage != nullptr)
+        stage->reset();
+
+  history.clear();
+  historyPos = 0;
+  fadeGain = 0.0f;
+}
+
+void Oversampler::setQuality(int newOrder, Filter newFilter) {
+  newOrder = juce::jlimit(0, maxOrder, newOrder);
+  if (newOrder == order && newFilter == filter)
+    return;
+
+  order = newOrder;
+  filter = newFilter;
+
+  const auto *stage =
+      order > 0 ? stages[(size_t)filter][(size_t)order - 1].get() : nullptr;
+  latency = stage != nullptr ? juce::roundToInt(stage->getLatencyInSamples())
+                             : 0;
+
+  reset();
+}
+
+void Oversampler::delayBypassed(juce::AudioBuffer<float> &buffer) {
+  // A zero-latency stage has nothing to line up with
+  if (latency == 0)
+    return;
+
+  const int numSamples = buffer.getNumSamples();
+  const int channels =
+      juce::jmin(buffer.getNumChannels(), history.getNumChannels());
+
+  for (int ch = 0; ch < channels; ++ch) {
+    auto *data = buffer.getWritePointer(ch);
+    auto *delay = history.getWritePointer(ch);
+    int pos = historyPos;
+
+    for (int i = 0; i < numSamples; ++i) {
+      std::swap(data[i], delay[pos]);
+      if (++pos == latency)
+        pos = 0;
+    }
+  }
+
+  historyPos = (historyPos + numSamples) % latency;
+}
+
+void Oversampler::recordHistory(const juce::AudioBuffer<float> &buffer) {
+  if (latency == 0)
+    return;
+
+  // Only the last `latency` inputs can still come out of the delay
+  const int numSamples = buffer.getNumSamples();
+  const int first = juce::jmax(0, numSamples - latency);
+  const int channels =
+      juce::jmin(buffer.getNumChannels(), history.getNumChannels());
+
+  for (int ch = 0; ch < channels; ++ch) {
+    const auto *data = buffer.getReadPointer(ch);
+    auto *delay = history.getWritePointer(ch);
+
+    for (int i = first; i < numSamples; ++i)
+      delay[(historyPos + i) % latency] = data[i];
+  }
+
+  historyPos = (historyPos + numSamples) % latency;
+}
+
+void Oversampler::crossfade(juce::AudioBuffer<float> &buffer,
+                            const juce::AudioBuffer<float> &dry,
+                            float target) {
+  const int numSamples = buffer.getNumSamples();
+  const float step = target > fadeGain ? fadeStep : -fadeStep;
+  float gain = fadeGain;
+
+  for (int ch = 0; ch < dry.getNumChannels(); ++ch) {
+    auto *data = buffer.getWritePointer(ch);
+    const auto *delayed = dry.getReadPointer(ch);
+    gain = fadeGain;
+
+    for (int i = 0; i < numSamples; ++i) {
+      gain = step > 0.0f ? juce::jmin(gain + step, target)
+                         : juce::jmax(gain + step, target);
+      data[i] = delayed[i] + gain * (data[i] - delayed[i]);
+    }
+  }
+
+  fadeGain = gain;
+}
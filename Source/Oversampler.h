@@ -0,0 +1,123 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Oversampling wrapper for a nonlinear stage.
+    Every factor (2x/4x/8x) and filter kind is built in prepare(), so the
+    quality can change on the audio thread without allocating. The wrapped
+    stage only runs oversampled while it is engaged; otherwise the input is
+    just delayed by the same amount, so the latency reported to the host
+    never depends on the signal.
+
+    The filters colour the phase, so the two paths don't line up exactly:
+    switching between them crossfades over a few milliseconds, running both
+    until it's done.
+*/
+class Oversampler {
+public:
+  // Half-band filters: the IIR is minimum phase with little latency, the
+  // FIR linear phase with more
+  enum class Filter { PolyphaseIIR = 0, EquirippleFIR };
+  static constexpr int maxOrder = 3; // 2^3 = 8x
+
+  Oversampler() = default;
+
+  void prepare(const juce::dsp::ProcessSpec &spec);
+  void reset();
+
+  // order 0 is off, 1..3 is 2x..8x
+  void setQuality(int newOrder, Filter newFilter);
+  int getOrder() const { return order; }
+  int getLatencySamples() const { return latency; }
+  // The most any quality can have, known after prepare()
+  int getMaxLatencySamples() const { return maxLatency; }
+
+  // Calls fn(block, order) on the oversampled block when engaged
+  template <typename ProcessFn>
+  void process(juce::AudioBuffer<float> &buffer, bool engaged, ProcessFn &&fn) {
+    juce::dsp::AudioBlock<float> block(buffer);
+
+    if (order == 0) {
+      if (engaged)
+        fn(block, 0);
+      return;
+    }
+
+    auto &stage = *stages[(size_t)filter][(size_t)order - 1];
+    const float target = engaged ? 1.0f : 0.0f;
+
+    // Settled on one path, or a block too long for the fade buffer (hard
+    // switch)
+    if (fadeGain == target || buffer.getNumSamples() > fade.getNumSamples()) {
+      jassert(buffer.getNumSamples() <= fade.getNumSamples());
+
+      if (!engaged) {
+        delayBypassed(buffer);
+        fadeGain = 0.0f;
+        return;
+      }
+
+      // The filters missed everything while bypassed
+      if (fadeGain == 0.0f)
+        stage.reset();
+      fadeGain = 1.0f;
+
+      recordHistory(buffer);
+      auto upsampled = stage.processSamplesUp(block);
+      fn(upsampled, order);
+      stage.processSamplesDown(block);
+      return;
+    }
+
+    if (fadeGain == 0.0f)
+      stage.reset();
+
+    // Both paths, the delayed one on a copy (which records the history too)
+    const int numSamples = buffer.getNumSamples();
+    const int channels = juce::jmin(buffer.getNumChannels(),
+                                    fade.getNumChannels());
+    juce::AudioBuffer<float> dry(fade.getArrayOfWritePointers(), channels,
+                                 numSamples);
+    for (int ch = 0; ch < channels; ++ch)
+      dry.copyFrom(ch, 0, buffer, ch, 0, numSamples);
+    delayBypassed(dry);
+
+    auto upsampled = stage.processSamplesUp(block);
+    fn(upsampled, order);
+    stage.processSamplesDown(block);
+
+    crossfade(buffer, dry, target);
+  }
+
+private:
+  // Bypassed blocks go through a plain delay of `latency` samples. The
+  // history also follows the input while engaged, so bypassing mid-note
+  // picks up exactly where the filters left off.
+  void delayBypassed(juce::AudioBuffer<float> &buffer);
+  void recordHistory(const juce::AudioBuffer<float> &buffer);
+  // Blends buffer (processed) with dry, moving fadeGain towards target
+  void crossfade(juce::AudioBuffer<float> &buffer,
+                 const juce::AudioBuffer<float> &dry, float target);
+
+  std::array<std::array<std::unique_ptr<juce::dsp::Oversampling<float>>,
+                        (size_t)maxOrder>,
+             2>
+      stages;
+
+  juce::AudioBuffer<float> history;
+  int historyPos = 0;
+
+  // Bypass <-> engaged crossfade: 0 = the plain delay, 1 = the stage
+  juce::AudioBuffer<float> fade;
+  float fadeGain = 0.0f;
+  float fadeStep = 1.0f;
+
+  int order = 0;
+  Filter filter = Filter::PolyphaseIIR;
+  int latency = 0;
+  int maxLatency = 0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Oversampler)
+};
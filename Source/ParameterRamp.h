@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ScratchArena.h"
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    One block of a smoothed parameter.
+    A smoother at rest comes out as a single value, so a stage can run its
+    constant-input kernel; only a smoother that is actually moving writes
+    per-sample values, into scratch memory that lives until the caller
+    rewinds the arena. If the arena is full the smoother jumps to its
+    target instead.
+*/
+struct ParameterRamp {
+  float *values = nullptr; // Per-sample values, nullptr when constant
+  float value = 0.0f;      // The constant, or the last value of the ramp
+
+  bool isConstant() const { return values == nullptr; }
+
+  // Advances the smoother by numSamples
+  static ParameterRamp next(juce::LinearSmoothedValue<float> &smoother,
+                            ScratchArena &scratch, int numSamples) {
+    if (!smoother.isSmoothing() || numSamples <= 0)
+      return {nullptr, smoother.getCurrentValue()};
+
+    auto *ramp = scratch.allocate(numSamples);
+    if (ramp == nullptr) {
+      smoother.skip(numSamples);
+      return {nullptr, smoother.getCurrentValue()};
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+      ramp[i] = smoother.getNextValue();
+
+    return {ramp, ramp[numSamples - 1]};
+  }
+
+  // Per-sample values either way (a constant is written out in full).
+  // Ramp values are handed out as they are, so the caller may map them in
+  // place. nullptr if the arena is full.
+  float *toBuffer(ScratchArena &scratch, int numSamples) const {
+    if (values != nullptr)
+      return values;
+
+    auto *buffer = scratch.allocate(numSamples);
+    if (buffer != nullptr)
+      juce::FloatVectorOperations::fill(buffer, value, numSamples);
+    return buffer;
+  }
+
+  // First value of the block. Ramps are monotonic, so this and `value`
+  // bound the whole block.
+  float getStart() const { return values != nullptr ? values[0] : value; }
+};
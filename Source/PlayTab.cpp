@@ -32,6 +32,17 @@ PlayTab::PlayTab(HowlingWolvesAudioProcessor &p) : audioProcessor(p) {
   initLabel(sustainLabel, "S");
   initLabel(releaseLabel, "R");
 
+  addAndMakeVisible(envCurveBox);
+  envCurveBox.addItem("Linear", 1);
+  envCurveBox.addItem("Exponential", 2);
+  envCurveBox.setJustificationType(juce::Justification::centred);
+  envCurveBox.setTooltip("Shape of the decay and release stages.");
+  if (audioProcessor.getAPVTS().getParameter("envCurve") != nullptr) {
+    envCurveAttachment = std::make_unique<
+        juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getAPVTS(), "envCurve", envCurveBox);
+  }
+
   addAndMakeVisible(adsrLabel);
   adsrLabel.setText("ENVELOPE", juce::dontSendNotification);
   adsrLabel.setFont(juce::Font(14.0f, juce::Font::bold));
@@ -86,10 +97,35 @@ PlayTab::PlayTab(HowlingWolvesAudioProcessor &p) : audioProcessor(p) {
   outputLabel.setText("OUTPUT", juce::dontSendNotification);
   outputLabel.setFont(juce::Font(14.0f, juce::Font::bold));
   outputLabel.setColour(juce::Label::textColourId, WolfColors::ACCENT_CYAN);
+
+  addAndMakeVisible(limiterToggle);
+  limiterToggle.setTooltip("Keeps the output's true peak under -1 dB, with "
+                           "1.5 ms of lookahead.");
+  limiterAttachment =
+      std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+          audioProcessor.getAPVTS(), "masterLimiter", limiterToggle);
+
+  initLabel(reductionLabel, "GR 0.0 dB");
+  reductionLabel.setJustificationType(juce::Justification::centredLeft);
+  reductionLabel.setTooltip("Gain reduction from the limiter.");
+
+  startTimerHz(15);
 }
 
 PlayTab::~PlayTab() {}
 
+void PlayTab::timerCallback() {
+  // Deepest reduction since the last tick, held and then let go at about
+  // 10 dB a second
+  const float reduction =
+      audioProcessor.getMasterStage().popGainReductionDb();
+  shownReduction = juce::jmin(reduction, shownReduction + 10.0f / 15.0f);
+  shownReduction = juce::jmin(0.0f, shownReduction);
+
+  reductionLabel.setText("GR " + juce::String(shownReduction, 1) + " dB",
+                         juce::dontSendNotification);
+}
+
 void PlayTab::setupKnob(
     juce::Slider &slider, const juce::String &name,
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
@@ -161,6 +197,9 @@ void PlayTab::resized() {
     layoutAdsrKnob(decaySlider, decayLabel);
     layoutAdsrKnob(sustainSlider, sustainLabel);
     layoutAdsrKnob(releaseSlider, releaseLabel);
+
+    envCurveBox.setBounds(
+        knobArea.removeFromLeft(100).withSizeKeepingCentre(100, 25));
   }
 
   area.removeFromTop(15); // Gap
@@ -195,7 +234,7 @@ void PlayTab::resized() {
 
   // 3. Output Section
   {
-    auto outputSection = area.removeFromTop(130);
+    auto outputSection = area.removeFromTop(160);
     outputLabel.setBounds(outputSection.removeFromTop(20));
     outputSection.removeFromTop(5);
 
@@ -210,5 +249,10 @@ void PlayTab::resized() {
     layoutOutputRow(gainSlider, gainLabel);
     layoutOutputRow(panSlider, panLabel);
     layoutOutputRow(tuneSlider, tuneLabel);
+
+    auto limiterRow = outputSection.removeFromTop(24);
+    limiterRow.removeFromLeft(55);
+    limiterToggle.setBounds(limiterRow.removeFromLeft(80));
+    reductionLabel.setBounds(limiterRow.removeFromLeft(100));
   }
 }
@@ -6,7 +6,7 @@
 #include <JuceHeader.h>
 
 //==============================================================================
-class PlayTab : public juce::Component {
+class PlayTab : public juce::Component, private juce::Timer {
 public:
   PlayTab(HowlingWolvesAudioProcessor &p);
   ~PlayTab() override;
@@ -15,6 +15,8 @@ public:
   void resized() override;
 
 private:
+  void timerCallback() override;
+
   HowlingWolvesAudioProcessor &audioProcessor;
 
   // Sidebar removed (moved to PluginEditor overlay)
@@ -25,6 +27,9 @@ private:
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
       attackAttachment, decayAttachment, sustainAttachment, releaseAttachment;
   juce::Label adsrLabel;
+  juce::ComboBox envCurveBox;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      envCurveAttachment;
 
   // Sample Control Section
   juce::Slider startSlider, endSlider;
@@ -42,6 +47,11 @@ private:
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
       gainAttachment, panAttachment, tuneAttachment;
   juce::Label outputLabel;
+  juce::ToggleButton limiterToggle{"Limiter"};
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment>
+      limiterAttachment;
+  juce::Label reductionLabel; // Limiter gain reduction
+  float shownReduction = 0.0f; // dB, falling back slowly
 
   // Helper to setup knobs
   void setupKnob(
@@ -1,6 +1,12 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+static double elapsedMs(juce::int64 startTicks) {
+  return juce::Time::highResolutionTicksToSeconds(
+             juce::Time::getHighResolutionTicks() - startTicks) *
+         1000.0;
+}
+
 //==============================================================================
 HowlingWolvesAudioProcessor::HowlingWolvesAudioProcessor()
     : AudioProcessor(
@@ -10,11 +16,25 @@ HowlingWolvesAudioProcessor::HowlingWolvesAudioProcessor()
               .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
       apvts(*this, nullptr, "Parameters", createParameterLayout()),
       sampleManager(synthEngine), presetManager(apvts, sampleManager) {
-  // Load initial samples
-  sampleManager.loadSamples();
+  // Kept minimal: hosts construct the plugin many times while scanning and
+  // loading sessions. Voices, sample formats and DSP buffers are created in
+  // prepareToPlay or on first use, and samples arrive with the first preset.
+  pipeline.setRenderStage(
+      [this](juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midi) {
+        renderSynthStage(buffer, midi);
+      });
+  pipeline.setWorkerPool(&workerPool);
+
+  startupTimings.constructionMs = elapsedMs(constructionStartTicks);
+  DBG("HowlingWolves: constructed in "
+      << startupTimings.constructionMs << " ms");
 }
 
-HowlingWolvesAudioProcessor::~HowlingWolvesAudioProcessor() {}
+HowlingWolvesAudioProcessor::~HowlingWolvesAudioProcessor() {
+  cancelPendingUpdate();
+  // The pool goes first: the convolution tail can't be out on it then
+  effectsProcessor.setWorkerPool(nullptr);
+}
 
 //==============================================================================
 const juce::String HowlingWolvesAudioProcessor::getName() const {
@@ -45,7 +65,33 @@ bool HowlingWolvesAudioProcessor::isMidiEffect() const {
 #endif
 }
 
-double HowlingWolvesAudioProcessor::getTailLengthSeconds() const { return 0.0; }
+double HowlingWolvesAudioProcessor::getTailLengthSeconds() const {
+  // A released note, then whatever the delay and reverb keep of it (the
+  // stages are in series, so their tails add up)
+  auto value = [this](const char *id, float fallback) {
+    auto *param = apvts.getRawParameterValue(id);
+    return param != nullptr ? param->load() : fallback;
+  };
+
+  double tail = value("release", 0.1f);
+
+  if (value("delayMix", 0.0f) > 0.0f) {
+    const double delaySeconds =
+        value("delaySync", 0.0f) > 0.5f
+            ? DelayEngine::getSyncedSeconds((int)value("delayDivision", 2.0f),
+                                            lastHostBpm.load())
+            : value("delayTime", 0.5f);
+    tail += DelayEngine::getTailSeconds(delaySeconds,
+                                        value("delayFeedback", 0.3f));
+  }
+
+  if (value("REVERB_MIX", 0.3f) > 0.0f)
+    tail += (int)value("roomMode", 0.0f) == 1
+                ? effectsProcessor.getConvolutionTailSeconds()
+                : FdnReverb::getTailSeconds(value("reverbSize", 0.5f));
+
+  return tail;
+}
 
 int HowlingWolvesAudioProcessor::getNumPrograms() {
   return 1; // NB: some hosts don't cope very well if you tell them there are 0
@@ -67,6 +113,21 @@ void HowlingWolvesAudioProcessor::changeProgramName(
 //==============================================================================
 void HowlingWolvesAudioProcessor::prepareToPlay(double sampleRate,
                                                 int samplesPerBlock) {
+  const auto prepareStartTicks = juce::Time::getHighResolutionTicks();
+
+  // Room for a few dozen block-sized mono buffers (plus alignment padding)
+  // covers the deepest stage: a voice with every modulation route active
+  scratchArena.prepare((size_t)scratchBuffersPerBlock *
+                       ((size_t)samplesPerBlock * sizeof(float) +
+                        ScratchArena::alignment));
+  synthEngine.setScratchArena(&scratchArena);
+  effectsProcessor.setScratchArena(&scratchArena);
+  masterStage.setScratchArena(&scratchArena);
+
+  // A worker renders the synth into its own arena while effects run here
+  pipeline.prepare(getTotalNumOutputChannels(), samplesPerBlock,
+                   scratchArena.getCapacity());
+
   synthEngine.setCurrentPlaybackSampleRate(sampleRate);
   synthEngine.prepare(sampleRate, samplesPerBlock);
   midiProcessor.prepare(sampleRate);
@@ -77,12 +138,101 @@ void HowlingWolvesAudioProcessor::prepareToPlay(double sampleRate,
   spec.maximumBlockSize = samplesPerBlock;
   spec.numChannels = getTotalNumOutputChannels();
 
+  // The saved routing and room go in before prepare, so the routing needs
+  // no fade and a convolution room is built up front
+  if (auto *chainOrderParam = apvts.getRawParameterValue("CHAIN_ORDER"))
+    effectsProcessor.setTopology(
+        EffectGraph::getPreset((int)chainOrderParam->load()));
+  if (auto *roomMode = apvts.getRawParameterValue("roomMode"))
+    effectsProcessor.setConvolutionReverb((int)roomMode->load() == 1);
   effectsProcessor.prepare(spec);
+  masterStage.prepare(spec);
+
+  // One pool for the sends, the pipelined synth and the convolution tail.
+  // Two workers at most (one where cores are few): whatever they haven't
+  // claimed runs on the audio thread anyway. They only start once any of
+  // those is used.
+  workerPool.prepare(
+      juce::jlimit(1, EffectGraph::maxBranches,
+                   juce::SystemStats::getNumCpus() - 2),
+      sampleRate, samplesPerBlock);
+  effectsProcessor.setWorkerPool(&workerPool);
+
+  // Shared bus filter and LFO (Paraphonic mode)
+  filterProcessor.prepare(spec);
+  lfoProcessor.prepare(sampleRate);
+  busLfoGain = 1.0f;
+  busLfoPan = 0.0f;
+
+  // The workers are started up front if pipelining is on; the latency is
+  // reported here before playback starts, later changes go through
+  // handleAsyncUpdate
+  auto *pipelinedParam = apvts.getRawParameterValue("pipelined");
+  const bool pipelined = pipelinedParam && pipelinedParam->load() > 0.5f;
+  if (pipelined)
+    workerPool.startWorkers();
+  updateOversampling();
+  setPipelined(pipelined && pipeline.isRunning());
+  setLatencySamples(pendingLatency.load());
+
+  startupTimings.prepareMs = elapsedMs(prepareStartTicks);
+  firstBlockPending = true;
+  DBG("HowlingWolves: prepared in " << startupTimings.prepareMs.load()
+                                    << " ms");
 }
 
 void HowlingWolvesAudioProcessor::releaseResources() {
   // When playback stops, you can use this as an opportunity to free up any
   // spare memory, etc.
+  effectsProcessor.setWorkerPool(nullptr);
+  workerPool.release();
+}
+
+void HowlingWolvesAudioProcessor::setPipelined(bool shouldPipeline) {
+  // Either way the synth stage gets scratch memory the effects aren't using
+  pipelineActive = shouldPipeline;
+  pipeline.reset();
+
+  auto *synthArena = shouldPipeline ? &pipeline.getArena() : &scratchArena;
+  synthEngine.setScratchArena(synthArena);
+
+  updateLatency();
+}
+
+void HowlingWolvesAudioProcessor::updateOversampling() {
+  // Every block: each stage switches here, on the audio thread that runs
+  // it (no-ops while unchanged). Only the resulting latency goes to the
+  // host, from the message thread.
+  auto *factorParam = apvts.getRawParameterValue("oversampling");
+  auto *modeParam = apvts.getRawParameterValue("osMode");
+
+  effectsProcessor.setOversampling(
+      factorParam ? (int)factorParam->load() : 0,
+      modeParam ? (Oversampler::Filter)(int)modeParam->load()
+                : Oversampler::Filter::PolyphaseIIR);
+
+  auto *lookaheadParam = apvts.getRawParameterValue("transientLookahead");
+  effectsProcessor.setBiteLookahead(lookaheadParam &&
+                                    lookaheadParam->load() > 0.5f);
+
+  auto *limiterParam = apvts.getRawParameterValue("masterLimiter");
+  masterStage.setLimiter(limiterParam && limiterParam->load() > 0.5f);
+  updateLatency();
+}
+
+void HowlingWolvesAudioProcessor::updateLatency() {
+  // Pipeline block plus the oversampled effect stages, Bite's lookahead
+  // and the limiter's
+  const int latency = (pipelineActive ? pipeline.getLatencySamples() : 0) +
+                      effectsProcessor.getLatencySamples() +
+                      masterStage.getLatencySamples();
+  if (pendingLatency.exchange(latency) != latency)
+    triggerAsyncUpdate();
+}
+
+void HowlingWolvesAudioProcessor::handleAsyncUpdate() {
+  // Tells the host too; no-op if unchanged
+  setLatencySamples(pendingLatency.load());
 }
 
 bool HowlingWolvesAudioProcessor::isBusesLayoutSupported(
@@ -96,7 +246,20 @@ bool HowlingWolvesAudioProcessor::isBusesLayoutSupported(
 
 void HowlingWolvesAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
                                                juce::MidiBuffer &midiMessages) {
+  // Times the first block after prepare (no logging on this thread)
+  const bool timeThisBlock = firstBlockPending.load();
+  const auto blockStartTicks =
+      timeThisBlock ? juce::Time::getHighResolutionTicks() : 0;
+  processBlockInternal(buffer, midiMessages);
+
+  if (timeThisBlock && firstBlockPending.exchange(false))
+    startupTimings.firstBlockMs = elapsedMs(blockStartTicks);
+}
+
+void HowlingWolvesAudioProcessor::processBlockInternal(
+    juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midiMessages) {
   juce::ScopedNoDenormals noDenormals;
+  scratchArena.reset();
   auto totalNumInputChannels = getTotalNumInputChannels();
   auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -129,10 +292,6 @@ void HowlingWolvesAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
   auto *lfoRateParam = apvts.getRawParameterValue("lfoRate");
   auto *lfoDepthParam = apvts.getRawParameterValue("lfoDepth");
 
-  // Output Parameters
-  auto *gainParam = apvts.getRawParameterValue("gain");
-  auto *panParam = apvts.getRawParameterValue("pan");
-
   // Effects Parameters
   auto *distDrive = apvts.getRawParameterValue("distDrive");
   auto *distMix = apvts.getRawParameterValue("distMix");
@@ -145,6 +304,7 @@ void HowlingWolvesAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
 
   // Apply parameters to synth engine
   auto *filterTypeParam = apvts.getRawParameterValue("filterType");
+  auto *filterVowelParam = apvts.getRawParameterValue("filterVowel");
 
   // Apply parameters to synth engine
   if (attackParam && decayParam && sustainParam && releaseParam &&
@@ -152,11 +312,33 @@ void HowlingWolvesAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
       filterTypeParam) {
 
     int fType = (int)filterTypeParam->load();
+    float vowel = filterVowelParam ? filterVowelParam->load() : 0.0f;
+
+    auto *engineModeParam = apvts.getRawParameterValue("engineMode");
+    synthEngine.setParaphonic(engineModeParam &&
+                              (int)engineModeParam->load() == 1);
+
+    if (auto *envCurveParam = apvts.getRawParameterValue("envCurve"))
+      synthEngine.setEnvelopeCurve(
+          (EnvelopeGenerator::Curve)(int)envCurveParam->load());
+
+    if (auto *lfoRetrigParam = apvts.getRawParameterValue("lfoRetrigger"))
+      synthEngine.setLfoRetrigger(lfoRetrigParam->load() > 0.5f);
+
+    auto *lfoWaveParam = apvts.getRawParameterValue("lfoWave");
+    auto *lfoTargetParam = apvts.getRawParameterValue("lfoTarget");
+    auto *envCutoffParam = apvts.getRawParameterValue("envCutoff");
+    auto *velCutoffParam = apvts.getRawParameterValue("velCutoff");
+    synthEngine.setModulation(
+        lfoWaveParam ? (int)lfoWaveParam->load() : 0,
+        lfoTargetParam ? (int)lfoTargetParam->load() : 0,
+        envCutoffParam ? envCutoffParam->load() : 0.0f,
+        velCutoffParam ? velCutoffParam->load() : 0.0f);
 
     synthEngine.updateParams(
         attackParam->load(), decayParam->load(), sustainParam->load(),
         releaseParam->load(), filterCutoffParam->load(), filterResParam->load(),
-        fType, lfoRateParam->load(), lfoDepthParam->load());
+        fType, vowel, lfoRateParam->load(), lfoDepthParam->load());
   }
 
   // --- Update Midi Processor ---
@@ -192,7 +374,8 @@ void HowlingWolvesAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
   }
 
   // --- MIDI Capture (After processing, before Synth) ---
-  midiCapturer.processMidi(midiMessages, buffer.getNumSamples());
+  midiCapturer.processMidi(midiMessages, buffer.getNumSamples(),
+                           getPlayHead());
 
   // --- Sample & Tune Parameters ---
   auto *tuneParam = apvts.getRawParameterValue("tune");
@@ -237,65 +420,179 @@ void HowlingWolvesAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
                                     delayFdbkVal, delayMixVal, revSizeVal,
                                     revDampVal, revMixVal, biteVal);
 
-  // Update Chain Order
-  auto *chainOrderParam = apvts.getRawParameterValue("CHAIN_ORDER");
-  if (chainOrderParam) {
-    int mode = (int)chainOrderParam->load();
-    using ET = EffectsProcessor::EffectType;
-    std::array<ET, 4> order;
-
-    // Standard: Dist -> Bite -> Delay -> Reverb
-    // Ethereal: Reverb -> Delay -> Dist -> Bite
-    // Chaos: Delay -> Dist -> Bite -> Reverb
-    // Reverse: Reverb -> Delay -> Bite -> Dist
-
-    switch (mode) {
-    default:
-    case 0:
-      order = {ET::Distortion, ET::TransientShaper, ET::Delay, ET::Reverb};
-      break;
-    case 1:
-      order = {ET::Reverb, ET::Delay, ET::Distortion, ET::TransientShaper};
-      break;
-    case 2:
-      order = {ET::Delay, ET::Distortion, ET::TransientShaper, ET::Reverb};
-      break;
-    case 3:
-      order = {ET::Reverb, ET::Delay, ET::TransientShaper, ET::Distortion};
-      break;
-    }
-    effectsProcessor.setChainOrder(order);
+  // Delay options; sync follows the host tempo (120 without one)
+  double hostBpm = 120.0;
+  if (auto *playHead = getPlayHead())
+    if (auto pos = playHead->getPosition())
+      if (pos->getBpm().hasValue())
+        hostBpm = *pos->getBpm();
+  lastHostBpm = hostBpm;
+
+  auto *delaySync = apvts.getRawParameterValue("delaySync");
+  auto *delayDivision = apvts.getRawParameterValue("delayDivision");
+  auto *delayPingPong = apvts.getRawParameterValue("delayPingPong");
+  auto *delayTone = apvts.getRawParameterValue("delayTone");
+  effectsProcessor.setDelayOptions(
+      delaySync && delaySync->load() > 0.5f,
+      delayDivision ? (int)delayDivision->load() : 2, hostBpm,
+      delayPingPong && delayPingPong->load() > 0.5f,
+      delayTone ? delayTone->load() : 1.0f);
+
+  if (auto *fxQuality = apvts.getRawParameterValue("fxQuality"))
+    effectsProcessor.setReverbLines((int)fxQuality->load() == 0 ? 8 : 16);
+  if (auto *parallelFx = apvts.getRawParameterValue("parallelFx"))
+    effectsProcessor.setParallelSends(parallelFx->load() > 0.5f);
+  if (auto *roomMode = apvts.getRawParameterValue("roomMode"))
+    effectsProcessor.setConvolutionReverb((int)roomMode->load() == 1);
+  updateOversampling();
+
+  // Effect routing (see EffectGraph::getPreset); only re-compiled when the
+  // choice changes
+  if (auto *chainOrderParam = apvts.getRawParameterValue("CHAIN_ORDER"))
+    effectsProcessor.setTopology(
+        EffectGraph::getPreset((int)chainOrderParam->load()));
+
+  // --- Synth and effects: in series, or pipelined across two threads ---
+  const int numSamples = buffer.getNumSamples();
+  // Switching on waits for the message thread to start the workers
+  auto *pipelinedParam = apvts.getRawParameterValue("pipelined");
+  const bool wantPipeline = pipelinedParam && pipelinedParam->load() > 0.5f;
+  if (wantPipeline && !pipeline.isRunning())
+    workerPool.requestWorkers();
+  const bool pipelined = wantPipeline && pipeline.isRunning();
+  if (pipelined != pipelineActive)
+    setPipelined(pipelined);
+
+  if (pipelineActive && numSamples > pipeline.getMaximumBlockSize()) {
+    // Larger than prepared for: render this one in series and start the
+    // pipeline over, keeping the reported latency
+    jassertfalse;
+    pipeline.reset();
+    renderSynthStage(buffer, midiMessages);
+    renderEffectsStage(buffer);
+  } else if (pipelineActive) {
+    // The worker renders this block's synth while the effects run on the
+    // one it rendered last time
+    pipeline.beginBlock(midiMessages, numSamples);
+    pipeline.readDelayed(buffer);
+    renderEffectsStage(buffer);
+    pipeline.endBlock();
+  } else {
+    renderSynthStage(buffer, midiMessages);
+    renderEffectsStage(buffer);
   }
+}
 
-  // Process synth
-  synthEngine.renderNextBlock(buffer, midiMessages, 0, buffer.getNumSamples());
+void HowlingWolvesAudioProcessor::renderSynthStage(
+    juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midiMessages) {
+  // Process synth (MIDI is batched to the render grain inside). With
+  // nothing sounding and nothing to start, the buffer stays cleared.
+  const int numSamples = buffer.getNumSamples();
+  const bool synthIdle =
+      midiMessages.isEmpty() && !synthEngine.hasActiveVoices();
 
-  // Process effects
-  effectsProcessor.process(buffer);
+  if (synthIdle)
+    synthEngine.skipBlock(numSamples);
+  else
+    synthEngine.renderBlock(buffer, midiMessages, numSamples);
 
-  // --- Master Section (Gain / Pan) ---
-  float gain = gainParam ? gainParam->load() : 0.5f;
-  float pan = panParam ? panParam->load() : 0.0f;
+  auto *filterCutoffParam = apvts.getRawParameterValue("filterCutoff");
+  auto *filterResParam = apvts.getRawParameterValue("filterRes");
+  auto *filterTypeParam = apvts.getRawParameterValue("filterType");
+  auto *lfoRateParam = apvts.getRawParameterValue("lfoRate");
+  auto *lfoDepthParam = apvts.getRawParameterValue("lfoDepth");
 
-  // Apply Master Gain
-  buffer.applyGain(gain);
+  // Paraphonic: one filter + LFO on the summed voices instead of N
+  if (synthEngine.isParaphonic() && filterCutoffParam && filterResParam &&
+      filterTypeParam && lfoRateParam && lfoDepthParam) {
+    auto *lfoWaveParam = apvts.getRawParameterValue("lfoWave");
+    auto *lfoTargetParam = apvts.getRawParameterValue("lfoTarget");
+
+    filterProcessor.setFilterType(
+        (FilterProcessor::FilterType)(int)filterTypeParam->load());
+    filterProcessor.setResonance(filterResParam->load());
+    if (auto *filterVowelParam = apvts.getRawParameterValue("filterVowel"))
+      filterProcessor.setVowel(filterVowelParam->load());
+    lfoProcessor.setRate(lfoRateParam->load());
+    lfoProcessor.setDepth(lfoDepthParam->load());
+    if (lfoWaveParam)
+      lfoProcessor.setWaveform(
+          (LFOProcessor::Waveform)(int)lfoWaveParam->load());
+    if (lfoTargetParam)
+      lfoProcessor.setTarget((LFOProcessor::Target)(int)lfoTargetParam->load());
+
+    // The bus filter rings on a little after the voices stop
+    const bool inputSilent = synthIdle || SilenceGate::isSilent(buffer);
+    if (busGate.canSkip(inputSilent, numSamples)) {
+      lfoProcessor.advance(numSamples);
+    } else {
+      processParaphonicBus(buffer, filterCutoffParam->load());
+      busGate.update(inputSilent, SilenceGate::isSilent(buffer), numSamples);
+    }
+  }
+}
 
-  // Apply Master Pan (Constant Power)
-  if (totalNumOutputChannels == 2) {
-    // Pan range -1.0 to 1.0
-    float angle = (pan + 1.0f) * (juce::MathConstants<float>::pi / 4.0f);
-    float leftGain = std::cos(angle);
-    float rightGain = std::sin(angle);
+void HowlingWolvesAudioProcessor::renderEffectsStage(
+    juce::AudioBuffer<float> &buffer) {
+  // Process effects
+  effectsProcessor.process(buffer);
 
-    buffer.applyGain(0, 0, buffer.getNumSamples(), leftGain);
-    buffer.applyGain(1, 0, buffer.getNumSamples(), rightGain);
-  }
+  // --- Master Section (Gain / Pan / Limiter), one stage ---
+  auto *gainParam = apvts.getRawParameterValue("gain");
+  auto *panParam = apvts.getRawParameterValue("pan");
+  masterStage.setGainAndPan(gainParam ? gainParam->load() : 0.5f,
+                            panParam ? panParam->load() : 0.0f);
+  masterStage.process(buffer);
 
   // Push to Visualizer
   if (audioVisualizerHook)
     audioVisualizerHook(buffer);
 }
 
+void HowlingWolvesAudioProcessor::processParaphonicBus(
+    juce::AudioBuffer<float> &buffer, float baseCutoff) {
+  // The shared LFO drives its target at control rate, with the same ranges
+  // as the voice modulation matrix, and the envelope and velocity routes
+  // move the cutoff. Pitch is still applied per voice.
+  using Matrix = ModulationMatrix;
+  constexpr int controlInterval = Matrix::controlInterval;
+  const int numSamples = buffer.getNumSamples();
+  const auto target = lfoProcessor.getTarget();
+
+  for (int pos = 0; pos < numSamples; pos += controlInterval) {
+    const int len = juce::jmin(controlInterval, numSamples - pos);
+
+    float lfoValue = lfoProcessor.advance(len);
+
+    float cutoffOctaves = synthEngine.getBusCutoffOctaves(pos);
+    if (target == LFOProcessor::FilterCutoff)
+      cutoffOctaves += lfoValue * Matrix::cutoffOctaves;
+    filterProcessor.setCutoff(juce::jlimit(
+        20.0f, 20000.0f, baseCutoff * std::exp2(cutoffOctaves)));
+
+    if (target == LFOProcessor::Volume) {
+      const float nextGain =
+          juce::jmax(0.0f, 1.0f + lfoValue * Matrix::gainRange);
+      buffer.applyGainRamp(pos, len, busLfoGain, nextGain);
+      busLfoGain = nextGain;
+    } else if (target == LFOProcessor::Pan && buffer.getNumChannels() == 2) {
+      // Balance rather than constant-power: the bus is already stereo
+      const float nextPan =
+          juce::jlimit(-1.0f, 1.0f, lfoValue * Matrix::panRange);
+      buffer.applyGainRamp(0, pos, len, juce::jmin(1.0f, 1.0f - busLfoPan),
+                           juce::jmin(1.0f, 1.0f - nextPan));
+      buffer.applyGainRamp(1, pos, len, juce::jmin(1.0f, 1.0f + busLfoPan),
+                           juce::jmin(1.0f, 1.0f + nextPan));
+      busLfoPan = nextPan;
+    }
+
+    // Refers to the section in place, no copy
+    juce::AudioBuffer<float> section(buffer.getArrayOfWritePointers(),
+                                     buffer.getNumChannels(), pos, len);
+    filterProcessor.process(section);
+  }
+}
+
 // Helper to update all params including new ones
 // synthEngine.updateParams(...) needs update.
 // I will do it in next step. For now volume works.
@@ -324,10 +621,35 @@ void HowlingWolvesAudioProcessor::setStateInformation(const void *data,
   if (xmlState.get() != nullptr) {
     if (xmlState->hasTagName(apvts.state.getType())) {
       apvts.replaceState(juce::ValueTree::fromXml(*xmlState));
+      restoreImpulseResponse();
     }
   }
 }
 
+void HowlingWolvesAudioProcessor::loadImpulseResponse(const juce::File &file) {
+  apvts.state.setProperty(impulseResponseId, file.getFullPathName(), nullptr);
+  restoreImpulseResponse();
+}
+
+void HowlingWolvesAudioProcessor::clearImpulseResponse() {
+  apvts.state.removeProperty(impulseResponseId, nullptr);
+  restoreImpulseResponse();
+}
+
+juce::File HowlingWolvesAudioProcessor::getImpulseResponseFile() const {
+  const auto path = apvts.state.getProperty(impulseResponseId).toString();
+  return path.isNotEmpty() ? juce::File(path) : juce::File();
+}
+
+void HowlingWolvesAudioProcessor::restoreImpulseResponse() {
+  // A session whose IR has gone missing falls back to the generated cave
+  const auto file = getImpulseResponseFile();
+  if (file.existsAsFile())
+    effectsProcessor.loadImpulseResponse(file);
+  else
+    effectsProcessor.clearImpulseResponse();
+}
+
 juce::AudioProcessorValueTreeState::ParameterLayout
 HowlingWolvesAudioProcessor::createParameterLayout() {
   juce::AudioProcessorValueTreeState::ParameterLayout layout;
@@ -349,16 +671,33 @@ HowlingWolvesAudioProcessor::createParameterLayout() {
                                                          0.0f, 1.0f, 1.0f));
   layout.add(std::make_unique<juce::AudioParameterFloat>("release", "Release",
                                                          0.01f, 5.0f, 0.1f));
+  layout.add(std::make_unique<juce::AudioParameterChoice>(
+      "envCurve", "Envelope Curve", juce::StringArray{"Linear", "Exponential"},
+      0));
 
   // Filter parameters
   layout.add(std::make_unique<juce::AudioParameterChoice>(
       "filterType", "Filter Type",
-      juce::StringArray{"Low Pass", "High Pass", "Band Pass", "Notch"}, 0));
+      juce::StringArray{"Low Pass", "High Pass", "Band Pass", "Notch",
+                        "Formant"},
+      0));
   layout.add(std::make_unique<juce::AudioParameterFloat>(
       "filterCutoff", "Filter Cutoff",
       juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.3f), 1000.0f));
   layout.add(std::make_unique<juce::AudioParameterFloat>(
       "filterRes", "Filter Resonance", 0.0f, 1.0f, 0.5f));
+  // Formant type only: A, E, I, O, U across the range
+  layout.add(std::make_unique<juce::AudioParameterFloat>(
+      "filterVowel", "Filter Vowel", 0.0f, 1.0f, 0.0f));
+  layout.add(std::make_unique<juce::AudioParameterFloat>(
+      "envCutoff", "Env > Cutoff", -1.0f, 1.0f, 0.0f));
+  layout.add(std::make_unique<juce::AudioParameterFloat>(
+      "velCutoff", "Velocity > Cutoff", 0.0f, 1.0f, 0.0f));
+
+  // Engine mode: Paraphonic shares one filter/envelope/LFO across voices
+  layout.add(std::make_unique<juce::AudioParameterChoice>(
+      "engineMode", "Engine Mode", juce::StringArray{"Poly", "Paraphonic"},
+      0));
 
   // LFO parameters
   layout.add(std::make_unique<juce::AudioParameterChoice>(
@@ -371,6 +710,9 @@ HowlingWolvesAudioProcessor::createParameterLayout() {
       juce::StringArray{"Filter Cutoff", "Volume", "Pan", "Pitch"}, 0));
   layout.add(std::make_unique<juce::AudioParameterFloat>(
       "lfoDepth", "LFO Depth", 0.0f, 1.0f, 0.5f));
+  // Off: one free-running LFO shared by all voices
+  layout.add(std::make_unique<juce::AudioParameterBool>(
+      "lfoRetrigger", "LFO Retrigger", true));
 
   // Sample Parameters (Added)
   layout.add(std::make_unique<juce::AudioParameterFloat>(
@@ -395,6 +737,15 @@ HowlingWolvesAudioProcessor::createParameterLayout() {
       "delayFeedback", "Delay Feedback", 0.0f, 0.95f, 0.3f));
   layout.add(std::make_unique<juce::AudioParameterFloat>(
       "delayMix", "Delay Mix", 0.0f, 1.0f, 0.0f));
+  layout.add(std::make_unique<juce::AudioParameterBool>(
+      "delaySync", "Delay Sync", false));
+  layout.add(std::make_unique<juce::AudioParameterChoice>(
+      "delayDivision", "Delay Division", DelayEngine::getDivisionNames(), 2));
+  layout.add(std::make_unique<juce::AudioParameterBool>(
+      "delayPingPong", "Delay Ping-Pong", false));
+  // Feedback lowpass: 1 leaves the repeats unfiltered
+  layout.add(std::make_unique<juce::AudioParameterFloat>(
+      "delayTone", "Delay Tone", 0.0f, 1.0f, 1.0f));
 
   // Reverb
   layout.add(std::make_unique<juce::AudioParameterFloat>(
@@ -434,10 +785,56 @@ HowlingWolvesAudioProcessor::createParameterLayout() {
       "HUNT_MODE", "Hunt Mode", juce::StringArray{"Stalk", "Chase", "Kill"},
       0));
 
-  // Signal Chain Order
+  // Signal Chain: serial orders, then delay/reverb as parallel sends
+  layout.add(std::make_unique<juce::AudioParameterChoice>(
+      "CHAIN_ORDER", "Signal Chain", EffectGraph::getPresetNames(), 0));
+
+  // Engine: render the synth on a worker thread, one block ahead of the
+  // effects. Adds a block of latency, so not something to automate.
+  layout.add(std::make_unique<juce::AudioParameterBool>(
+      "pipelined", "Pipelined Render", false,
+      juce::AudioParameterBoolAttributes().withAutomatable(false)));
+
+  // Output: lookahead limiter holding the true peak under -1 dBTP. Adds
+  // 1.5 ms of latency, so not automatable.
+  layout.add(std::make_unique<juce::AudioParameterBool>(
+      "masterLimiter", "Safety Limiter", false,
+      juce::AudioParameterBoolAttributes().withAutomatable(false)));
+
+  // Engine: run the effect sends on worker threads in large blocks. Same
+  // sound either way.
+  layout.add(std::make_unique<juce::AudioParameterBool>(
+      "parallelFx", "Parallel Sends", true,
+      juce::AudioParameterBoolAttributes().withAutomatable(false)));
+
+  // Oversampling for Distortion and Bite. Changes the latency, so not
+  // automatable either.
+  layout.add(std::make_unique<juce::AudioParameterChoice>(
+      "oversampling", "Oversampling",
+      juce::StringArray{"Off", "2x", "4x", "8x"}, 1,
+      juce::AudioParameterChoiceAttributes().withAutomatable(false)));
+  layout.add(std::make_unique<juce::AudioParameterChoice>(
+      "osMode", "Oversampling Mode",
+      juce::StringArray{"Low Latency", "Linear Phase"}, 0,
+      juce::AudioParameterChoiceAttributes().withAutomatable(false)));
+
+  // Bite lookahead: catches attacks whole, for 2 ms of latency
+  layout.add(std::make_unique<juce::AudioParameterBool>(
+      "transientLookahead", "Bite Lookahead", false,
+      juce::AudioParameterBoolAttributes().withAutomatable(false)));
+
+  // Reverb density vs CPU: Eco runs 8 delay lines, High 16. Switching
+  // clears the tail.
+  layout.add(std::make_unique<juce::AudioParameterChoice>(
+      "fxQuality", "FX Quality", juce::StringArray{"Eco", "High"}, 0,
+      juce::AudioParameterChoiceAttributes().withAutomatable(false)));
+
+  // Reverb engine: the delay network, or a convolution with a loaded IR
+  // (a generated cave until one is loaded)
   layout.add(std::make_unique<juce::AudioParameterChoice>(
-      "CHAIN_ORDER", "Signal Chain",
-      juce::StringArray{"Standard", "Ethereal", "Chaos", "Reverse"}, 0));
+      "roomMode", "Reverb Mode",
+      juce::StringArray{"Algorithmic", "Convolution"}, 0,
+      juce::AudioParameterChoiceAttributes().withAutomatable(false)));
 
   return layout;
 }
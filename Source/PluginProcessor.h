@@ -4,14 +4,19 @@
 #include "FilterProcessor.h"
 #include "HuntEngine.h"
 #include "LFOProcessor.h"
+#include "MasterStage.h"
 #include "MidiCapturer.h"
 #include "MidiProcessor.h"
 #include "PresetManager.h"
 #include "SampleManager.h"
+#include "ScratchArena.h"
 #include "SynthEngine.h"
+#include "SynthPipeline.h"
+#include "WorkerPool.h"
 #include <JuceHeader.h>
 
-class HowlingWolvesAudioProcessor : public juce::AudioProcessor {
+class HowlingWolvesAudioProcessor : public juce::AudioProcessor,
+                                    private juce::AsyncUpdater {
 public:
   //==============================================================================
   HowlingWolvesAudioProcessor();
@@ -57,6 +62,23 @@ public:
   PresetManager &getPresetManager() { return presetManager; }
   HuntEngine &getHuntEngine() { return huntEngine; }
   MidiCapturer &getMidiCapturer() { return midiCapturer; }
+  MasterStage &getMasterStage() { return masterStage; }
+
+  // Message thread: the convolution reverb's IR, saved with the session.
+  // Cleared, it plays the generated cave.
+  void loadImpulseResponse(const juce::File &file);
+  void clearImpulseResponse();
+  juce::File getImpulseResponseFile() const;
+
+  // Startup cost in milliseconds, shown in Settings so session-load
+  // regressions are visible. The first block is the first processBlock
+  // after prepareToPlay (cold caches, first voice allocation).
+  struct StartupTimings {
+    double constructionMs = 0.0;
+    std::atomic<double> prepareMs{0.0};
+    std::atomic<double> firstBlockMs{0.0};
+  };
+  const StartupTimings &getStartupTimings() const { return startupTimings; }
 
   // Visualizer FIFO
   // Ideally, PluginProcessor polls this, but we need to push to it.
@@ -80,7 +102,36 @@ public:
 private:
   //==============================================================================
   juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+  // First data member, so construction timing covers the APVTS as well
+  const juce::int64 constructionStartTicks =
+      juce::Time::getHighResolutionTicks();
+  StartupTimings startupTimings;
+  std::atomic<bool> firstBlockPending{true}; // Set in prepare, audio clears
+
+  void processParaphonicBus(juce::AudioBuffer<float> &buffer, float baseCutoff);
+  void processBlockInternal(juce::AudioBuffer<float> &buffer,
+                            juce::MidiBuffer &midiMessages);
+
+  // processBlock stages: the synth stage runs on a pool worker when
+  // pipelined, the effects stage always on the audio thread
+  void renderSynthStage(juce::AudioBuffer<float> &buffer,
+                        juce::MidiBuffer &midiMessages);
+  void renderEffectsStage(juce::AudioBuffer<float> &buffer);
+  void setPipelined(bool shouldPipeline);
+  void updateOversampling();
+  // Audio thread: works out the latency and, if it moved, has the message
+  // thread report it
+  void updateLatency();
+  // Message thread: reports the latency to the host
+  void handleAsyncUpdate() override;
+  void restoreImpulseResponse();
   juce::AudioProcessorValueTreeState apvts;
+  static inline const juce::Identifier impulseResponseId{"impulseResponse"};
+
+  // Temporary buffers for every stage, reset at the top of processBlock
+  ScratchArena scratchArena;
+  static constexpr int scratchBuffersPerBlock = 32;
 
   SynthEngine synthEngine;
   SampleManager sampleManager;
@@ -90,11 +141,26 @@ private:
   // Filter and LFO
   FilterProcessor filterProcessor;
   LFOProcessor lfoProcessor;
+  float busLfoGain = 1.0f; // Last control-rate values on the paraphonic bus
+  float busLfoPan = 0.0f;
+  SilenceGate busGate; // Lets the bus filter ring out, then sleep
   EffectsProcessor effectsProcessor;
+  MasterStage masterStage; // Gain, pan and the safety limiter
   MidiProcessor midiProcessor;
   HuntEngine huntEngine;
   MidiCapturer midiCapturer;
 
+  SynthPipeline pipeline;
+  bool pipelineActive = false;
+  std::atomic<int> pendingLatency{0}; // Latest total, for the host
+
+  // Realtime workers for the sends, the pipeline and the convolution tail.
+  // Declared last, so it stops before anything that hands it work goes.
+  WorkerPool workerPool;
+
+  // Last tempo from the host, for the synced delay's share of the tail
+  std::atomic<double> lastHostBpm{120.0};
+
   //==============================================================================
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HowlingWolvesAudioProcessor)
 };
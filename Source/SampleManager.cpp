@@ -1,11 +1,15 @@
 #include "SampleManager.h"
 
-SampleManager::SampleManager(SynthEngine &s) : synthEngine(s) {
-  formatManager.registerBasicFormats();
-}
+SampleManager::SampleManager(SynthEngine &s) : synthEngine(s) {}
 
 SampleManager::~SampleManager() {}
 
+juce::AudioFormatManager &SampleManager::getFormatManager() {
+  if (formatManager.getNumKnownFormats() == 0)
+    formatManager.registerBasicFormats();
+  return formatManager;
+}
+
 // Helper to get standard location: ~/Music/Wolf Instruments/Howling
 // Wolves/Samples
 // Helper to get standard location: ~/Music/Wolf Instruments/Howling
@@ -16,7 +20,8 @@ SampleManager::~SampleManager() {}
 void SampleManager::loadSamples() {
   // Initial load can be left empty or load a default welcome sound.
   // We rely on the user selecting a preset.
-  synthEngine.clearSounds();
+  synthEngine.releaseSounds();
+  updatePinnedBytes();
 }
 
 void SampleManager::loadSound(const juce::File &file) {
@@ -26,10 +31,10 @@ void SampleManager::loadSound(const juce::File &file) {
   currentSamplePath = file.getFullPathName();
 
   // Clear current sounds first so we don't play the old one if this load fails
-  synthEngine.clearSounds();
+  synthEngine.releaseSounds();
 
   std::unique_ptr<juce::AudioFormatReader> reader(
-      formatManager.createReaderFor(file));
+      getFormatManager().createReaderFor(file));
 
   if (reader != nullptr) {
     juce::BigInteger allNotes;
@@ -154,6 +159,8 @@ void SampleManager::loadSound(const juce::File &file) {
   } else {
     DBG("Failed to load sample: " + file.getFullPathName());
   }
+
+  updatePinnedBytes();
 }
 
 void SampleManager::loadDrumKit(const juce::File &kitDirectory) {
@@ -161,9 +168,9 @@ void SampleManager::loadDrumKit(const juce::File &kitDirectory) {
     return;
 
   // Clear existing sounds (Kit replaces current set)
-  synthEngine.clearSounds();
+  synthEngine.releaseSounds();
 
-  auto allowedExtensions = formatManager.getWildcardForAllFormats();
+  auto allowedExtensions = getFormatManager().getWildcardForAllFormats();
   int midiNote = 36; // Start at C1 (Standard Drum Map)
   int count = 0;
 
@@ -175,7 +182,7 @@ void SampleManager::loadDrumKit(const juce::File &kitDirectory) {
       break; // Limit to 16 pads
 
     std::unique_ptr<juce::AudioFormatReader> reader(
-        formatManager.createReaderFor(file));
+        getFormatManager().createReaderFor(file));
 
     if (reader != nullptr) {
       // Map to SINGLE note
@@ -198,8 +205,27 @@ void SampleManager::loadDrumKit(const juce::File &kitDirectory) {
       count++;
     }
   }
+
+  updatePinnedBytes();
 }
 
 juce::String SampleManager::getCurrentSamplePath() const {
   return currentSamplePath;
 }
+
+void SampleManager::updatePinnedBytes() {
+  std::vector<MemoryLock::PageRange> pages;
+  {
+    // Same lock the synth takes when sounds are added or cleared
+    const juce::ScopedLock sl(synthEngine.getLock());
+    for (int i = 0; i < synthEngine.getNumSounds(); ++i) {
+      if (auto *sound =
+              dynamic_cast<HowlingSound *>(synthEngine.getSound(i).get()))
+        sound->addLockedPages(pages);
+    }
+  }
+
+  pinnedBytes = MemoryLock::countUniqueBytes(std::move(pages));
+  DBG("Pinned sample memory: " +
+      juce::File::descriptionOfSizeInBytes((juce::int64)pinnedBytes.load()));
+}
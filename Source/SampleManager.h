@@ -18,8 +18,20 @@ public:
 
   juce::String getCurrentSamplePath() const;
 
+  // Sample memory locked in RAM across the loaded sounds, as of the last
+  // load. Safe from any thread.
+  size_t getPinnedBytes() const { return pinnedBytes.load(); }
+
 private:
+  // Recounts pinnedBytes after the sounds change (pages shared between
+  // sounds or channels count once)
+  void updatePinnedBytes();
+
+  // Registered on first use: hosts scanning the plugin never load a sample
+  juce::AudioFormatManager &getFormatManager();
+
   SynthEngine &synthEngine;
   juce::AudioFormatManager formatManager;
   juce::String currentSamplePath;
+  std::atomic<size_t> pinnedBytes{0};
 };
@@ -0,0 +1,53 @@
+#include "ScratchArena.h"
+
+static size_t alignUp(size_t value) {
+  return (value + ScratchArena::alignment - 1) & ~(ScratchArena::alignment - 1);
+}
+
+void ScratchArena::prepare(size_t capacityInBytes) {
+  // Grow to whatever the last run actually needed
+  capacity = alignUp(juce::jmax(capacityInBytes, highWaterMark));
+
+  storage.allocate(capacity + alignment, true);
+  base = reinterpret_cast<char *>(
+      alignUp(reinterpret_cast<size_t>(storage.getData())));
+
+  used = 0;
+  overflowed = false;
+}
+
+void ScratchArena::reset() {
+  used = 0;
+  overflowed = false;
+}
+
+void *ScratchArena::allocateBytes(size_t numBytes) {
+  const size_t size = alignUp(numBytes);
+
+  if (used + size > capacity) {
+    // Sized too small in prepare(); the next prepare() grows to fit
+    jassertfalse;
+    highWaterMark = juce::jmax(highWaterMark, used + size);
+    overflowed = true;
+    return nullptr;
+  }
+
+  void *result = base + used;
+  used += size;
+  highWaterMark = juce::jmax(highWaterMark, used);
+  return result;
+}
+
+juce::AudioBuffer<float> ScratchArena::makeBuffer(int numChannels,
+                                                  int numSamples) {
+  // AudioBuffer copies the channel pointers into its own small array
+  float *channels[32] = {};
+  jassert(numChannels < 32);
+  numChannels = juce::jmin(numChannels, 31);
+
+  for (int ch = 0; ch < numChannels; ++ch)
+    if ((channels[ch] = allocate(numSamples)) == nullptr)
+      return {};
+
+  return juce::AudioBuffer<float>(channels, numChannels, numSamples);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Preallocated scratch memory for the audio thread.
+    Sized in prepareToPlay, reset once per processBlock and handed to every
+    stage that needs temporary buffers. Allocation is a pointer bump rounded
+    up to a cache line, so consecutive stages (and voices, which rewind after
+    themselves) keep reusing the same hot memory.
+    Running out is a bug: it asserts in debug builds, and in release the
+    allocation returns nullptr, nothing is allocated on the audio thread,
+    and the stage asking passes its input through (or goes quiet) for that
+    block. The next prepare() grows to what was asked for.
+*/
+class ScratchArena {
+public:
+  static constexpr size_t alignment = 64;
+
+  ScratchArena() = default;
+
+  // Message thread: (re)allocates the backing store
+  void prepare(size_t capacityInBytes);
+
+  // Audio thread: releases everything handed out since the last reset
+  void reset();
+
+  // nullptr if the arena is full
+  void *allocateBytes(size_t numBytes);
+  float *allocate(int numFloats) {
+    return static_cast<float *>(
+        allocateBytes((size_t)numFloats * sizeof(float)));
+  }
+
+  // A buffer referring to arena memory (contents are uninitialised), with
+  // no channels if the arena is full
+  juce::AudioBuffer<float> makeBuffer(int numChannels, int numSamples);
+
+  // True if an allocation failed since the last reset or rewind point, so
+  // a stage can check once after asking for all it needs
+  bool hasOverflowed() const { return overflowed; }
+
+  size_t getCapacity() const { return capacity; }
+  size_t getHighWaterMark() const { return highWaterMark; }
+
+  // Restores the arena to its current position when it goes out of scope
+  class ScopedRewind {
+  public:
+    explicit ScopedRewind(ScratchArena &arenaToUse)
+        : arena(arenaToUse), mark(arenaToUse.used),
+          overflowed(arenaToUse.overflowed) {
+      arena.overflowed = false;
+    }
+    ~ScopedRewind() {
+      arena.used = mark;
+      arena.overflowed = overflowed;
+    }
+
+  private:
+    ScratchArena &arena;
+    size_t mark;
+    bool overflowed;
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedRewind)
+  };
+
+private:
+  juce::HeapBlock<char> storage;
+  char *base = nullptr; // storage rounded up to the alignment
+  size_t capacity = 0;
+  size_t used = 0;
+  size_t highWaterMark = 0;
+  bool overflowed = false;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ScratchArena)
+};
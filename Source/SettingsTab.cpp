@@ -1,7 +1,6 @@
 #include "SettingsTab.h"
 
 SettingsTab::SettingsTab(HowlingWolvesAudioProcessor &p) : audioProcessor(p) {
-  juce::ignoreUnused(audioProcessor);
   // --- MIDI Section ---
   addAndMakeVisible(midiLabel);
   midiLabel.setText("MIDI SETTINGS", juce::dontSendNotification);
@@ -55,6 +54,22 @@ SettingsTab::SettingsTab(HowlingWolvesAudioProcessor &p) : audioProcessor(p) {
     }
   };
 
+  addAndMakeVisible(pipelineToggle);
+  pipelineToggle.setTooltip("Renders the synth on a second thread, one block "
+                            "ahead of the effects. More headroom for big "
+                            "patches at the cost of one block of latency.");
+  pipelineAttachment =
+      std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+          audioProcessor.getAPVTS(), "pipelined", pipelineToggle);
+
+  addAndMakeVisible(parallelToggle);
+  parallelToggle.setTooltip("Runs the delay and reverb sends on worker "
+                            "threads alongside the rest of the chain, at "
+                            "larger buffer sizes.");
+  parallelAttachment =
+      std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+          audioProcessor.getAPVTS(), "parallelFx", parallelToggle);
+
   // --- About Section ---
   addAndMakeVisible(aboutLabel);
   aboutLabel.setText("WOLF INSTRUMENTS", juce::dontSendNotification);
@@ -67,6 +82,18 @@ SettingsTab::SettingsTab(HowlingWolvesAudioProcessor &p) : audioProcessor(p) {
   versionLabel.setColour(juce::Label::textColourId, WolfColors::TEXT_SECONDARY);
   versionLabel.setJustificationType(juce::Justification::centred);
 
+  addAndMakeVisible(memoryLabel);
+  memoryLabel.setColour(juce::Label::textColourId, WolfColors::TEXT_SECONDARY);
+  memoryLabel.setJustificationType(juce::Justification::centred);
+  memoryLabel.setTooltip("Sample data locked in RAM so note starts never wait "
+                         "on the disk.");
+
+  addAndMakeVisible(timingLabel);
+  timingLabel.setColour(juce::Label::textColourId, WolfColors::TEXT_SECONDARY);
+  timingLabel.setJustificationType(juce::Justification::centred);
+  timingLabel.setTooltip("Time to create the plugin, prepare it for playback "
+                         "and render its first block.");
+
   addAndMakeVisible(panicButton);
   panicButton.setButtonText("PANIC / ALL OFF");
   panicButton.setTooltip("Stops all playing notes immediately.");
@@ -76,10 +103,29 @@ SettingsTab::SettingsTab(HowlingWolvesAudioProcessor &p) : audioProcessor(p) {
     // Implement panic functionality (clear voices)
     // audioProcessor.clearVoices(); // Need to implement this in processor
   };
+
+  timerCallback();
+  startTimerHz(1);
 }
 
 SettingsTab::~SettingsTab() {}
 
+void SettingsTab::timerCallback() {
+  const auto pinned = audioProcessor.getSampleManager().getPinnedBytes();
+  memoryLabel.setText("Pinned sample memory: " +
+                          juce::File::descriptionOfSizeInBytes(
+                              (juce::int64)pinned),
+                      juce::dontSendNotification);
+
+  const auto &timings = audioProcessor.getStartupTimings();
+  timingLabel.setText(
+      "Startup: " + juce::String(timings.constructionMs, 1) +
+          " ms / prepare " + juce::String(timings.prepareMs.load(), 1) +
+          " ms / first block " + juce::String(timings.firstBlockMs.load(), 2) +
+          " ms",
+      juce::dontSendNotification);
+}
+
 void SettingsTab::paint(juce::Graphics &g) {
   auto area = getLocalBounds().reduced(20);
 
@@ -129,8 +175,17 @@ void SettingsTab::resized() {
   juce::FlexBox uiFlex;
   uiFlex.justifyContent = juce::FlexBox::JustifyContent::center;
   uiFlex.alignItems = juce::FlexBox::AlignItems::center;
+  uiFlex.flexWrap = juce::FlexBox::Wrap::wrap;
   uiFlex.items.add(juce::FlexItem(scaleLabel).withWidth(50).withHeight(30));
   uiFlex.items.add(juce::FlexItem(scaleBox).withWidth(100).withHeight(30));
+  uiFlex.items.add(juce::FlexItem(pipelineToggle)
+                       .withWidth(100)
+                       .withHeight(30)
+                       .withMargin({0, 0, 0, 10}));
+  uiFlex.items.add(juce::FlexItem(parallelToggle)
+                       .withWidth(100)
+                       .withHeight(30)
+                       .withMargin({0, 0, 0, 10}));
   uiFlex.performLayout(uiArea);
 
   // Layout About
@@ -141,6 +196,10 @@ void SettingsTab::resized() {
 
   aboutFlex.items.add(juce::FlexItem(aboutLabel).withHeight(40));
   aboutFlex.items.add(juce::FlexItem(versionLabel).withHeight(20));
+  aboutFlex.items.add(
+      juce::FlexItem(memoryLabel).withWidth(300).withHeight(20));
+  aboutFlex.items.add(
+      juce::FlexItem(timingLabel).withWidth(400).withHeight(20));
   aboutFlex.items.add(juce::FlexItem(panicButton)
                           .withWidth(150)
                           .withHeight(30)
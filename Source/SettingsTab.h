@@ -5,7 +5,7 @@
 #include <JuceHeader.h>
 
 //==============================================================================
-class SettingsTab : public juce::Component {
+class SettingsTab : public juce::Component, private juce::Timer {
 public:
   SettingsTab(HowlingWolvesAudioProcessor &p);
   ~SettingsTab() override;
@@ -14,6 +14,8 @@ public:
   void resized() override;
 
 private:
+  void timerCallback() override;
+
   HowlingWolvesAudioProcessor &audioProcessor;
 
   // MIDI Settings
@@ -27,10 +29,18 @@ private:
   juce::Label uiLabel;
   juce::ComboBox scaleBox;
   juce::Label scaleLabel;
+  juce::ToggleButton pipelineToggle{"Pipelined"};
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment>
+      pipelineAttachment;
+  juce::ToggleButton parallelToggle{"Parallel FX"};
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment>
+      parallelAttachment;
 
   // About / Info
   juce::Label aboutLabel;
   juce::Label versionLabel;
+  juce::Label memoryLabel;
+  juce::Label timingLabel;
   juce::TextButton panicButton;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SettingsTab)
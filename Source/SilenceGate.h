@@ -0,0 +1,58 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <utility>
+
+//==============================================================================
+/**
+    Lets a stage sleep through silence.
+    Counts how long the stage's input and output have both stayed below the
+    threshold. Once that is longer than its memory (delay lines, filter or
+    oversampling history), everything it holds was written from silence and
+    the stage can be skipped.
+    The output alone isn't enough: a stage mixed in at a low level can be
+    quiet while its memory is not. Only feedback can keep anything in
+    there, so stages that have it clear their memory when they fall asleep
+    rather than replay it on waking.
+*/
+class SilenceGate {
+public:
+  static constexpr float threshold = 1.0e-5f; // -100 dBFS
+
+  // A cleared buffer is known silent without looking at it
+  static bool isSilent(const juce::AudioBuffer<float> &buffer) {
+    if (buffer.hasBeenCleared())
+      return true;
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+      if (buffer.getMagnitude(ch, 0, buffer.getNumSamples()) >= threshold)
+        return false;
+
+    return true;
+  }
+
+  bool canSkip(bool inputSilent, int tailSamples) const {
+    return inputSilent && quietSamples >= tailSamples;
+  }
+
+  // True on the first skipped block after the stage last ran
+  bool fallAsleep() { return !std::exchange(asleep, true); }
+
+  // After the stage has run on a block
+  void update(bool inputSilent, bool outputSilent, int numSamples) {
+    quietSamples = inputSilent && outputSilent
+                       ? juce::jmin(quietSamples + numSamples, maxCount)
+                       : 0;
+    asleep = false;
+  }
+
+  void reset() {
+    quietSamples = 0;
+    asleep = false;
+  }
+
+private:
+  static constexpr int maxCount = std::numeric_limits<int>::max() / 2;
+  int quietSamples = 0;
+  bool asleep = false;
+};
@@ -1,12 +1,38 @@
 #include "SynthEngine.h"
 
+//==============================================================================
+// HowlingSound
+//==============================================================================
+
+void HowlingSound::lockHead() {
+  auto *data = getAudioData();
+  if (data == nullptr || length <= 0)
+    return;
+
+  // Plus the guard samples the interpolator reads past the end
+  const int headSamples =
+      juce::jmin(data->getNumSamples(),
+                 (int)(lockedHeadSeconds * sourceSampleRate) + 4);
+
+  for (int ch = 0; ch < data->getNumChannels(); ++ch)
+    headLocks.push_back(std::make_unique<MemoryLock>(
+        data->getReadPointer(ch), (size_t)headSamples * sizeof(float)));
+}
+
+void HowlingSound::addLockedPages(
+    std::vector<MemoryLock::PageRange> &pages) const {
+  for (auto &lock : headLocks)
+    if (lock->isLocked())
+      pages.push_back(lock->getLockedPages());
+}
+
 //==============================================================================
 // HowlingVoice
 //==============================================================================
 
 HowlingVoice::HowlingVoice() {
-  // Placeholder init
-  lfo.initialise([](float x) { return std::sin(x); });
+  // Depth is applied by the modulation matrix
+  lfo.setDepth(1.0f);
 
   // Initialize ADSR with default
   adsr.setSampleRate(44100.0); // Will be updated in prepare
@@ -22,8 +48,10 @@ void HowlingVoice::prepare(double sampleRate, int samplesPerBlock) {
 
   filter.prepare(spec);
   filter.setType(juce::dsp::StateVariableTPTFilterType::lowpass);
+  formants.prepare(sampleRate, 1);
 
-  lfo.prepare(spec);
+  lfo.prepare(sampleRate);
+  sharedLfo = nullptr;
 
   adsr.setSampleRate(sampleRate);
 
@@ -31,16 +59,18 @@ void HowlingVoice::prepare(double sampleRate, int samplesPerBlock) {
   crossoverFilter.prepare(spec);
   crossoverFilter.setType(juce::dsp::LinkwitzRileyFilterType::lowpass);
   crossoverFilter.setCutoffFrequency(120.0f);
-
-  // Resize temp buffer for processing
-  tempBuffer.setSize(1, samplesPerBlock); // Mono voice
 }
 
-void HowlingVoice::updateFilter(float cutoff, float resonance, int filterType) {
+void HowlingVoice::updateFilter(float cutoff, float resonance, int filterType,
+                                float vowel) {
   baseCutoff = cutoff;
   baseResonance = resonance;
+  currentFilterType = filterType;
   filter.setCutoffFrequency(cutoff);
-  filter.setResonance(resonance);
+  filter.setResonance(FilterProcessor::resonanceToQ(resonance));
+  // Both only recompute the bank's coefficients when they move
+  formants.setVowel(vowel);
+  formants.setResonance(resonance);
 
   switch (filterType) {
   case 0:
@@ -59,6 +89,9 @@ void HowlingVoice::updateFilter(float cutoff, float resonance, int filterType) {
     filter.setType(juce::dsp::StateVariableTPTFilterType::bandpass);
     isNotch = true;
     break;
+  case formantType:
+    isNotch = false;
+    break;
   default:
     filter.setType(juce::dsp::StateVariableTPTFilterType::lowpass);
     isNotch = false;
@@ -66,9 +99,9 @@ void HowlingVoice::updateFilter(float cutoff, float resonance, int filterType) {
   }
 }
 
-void HowlingVoice::updateLFO(float rate, float depth) {
-  lfo.setFrequency(rate);
-  lfoDepth = depth;
+void HowlingVoice::updateLFO(float rate, LFOProcessor::Waveform waveform) {
+  lfo.setRate(rate);
+  lfo.setWaveform(waveform);
 }
 
 void HowlingVoice::updateADSR(float attack, float decay, float sustain,
@@ -77,7 +110,36 @@ void HowlingVoice::updateADSR(float attack, float decay, float sustain,
   adsrParams.decay = decay;
   adsrParams.sustain = sustain;
   adsrParams.release = release;
-  adsr.setParameters(adsrParams);
+
+  if (paraphonic)
+    adsr.setParameters({gateAttack, 0.0f, 1.0f, gateRelease});
+  else
+    adsr.setParameters(adsrParams);
+}
+
+void HowlingVoice::setEnvelopeCurve(EnvelopeGenerator::Curve curve) {
+  adsr.setCurve(curve);
+}
+
+void HowlingVoice::setParaphonic(bool shouldBeParaphonic,
+                                 const EnvelopeGenerator *sharedEnv) {
+  sharedEnvelope = sharedEnv;
+
+  if (paraphonic == shouldBeParaphonic)
+    return;
+
+  paraphonic = shouldBeParaphonic;
+  releaseParaphonicHold();
+  updateADSR(adsrParams.attack, adsrParams.decay, adsrParams.sustain,
+             adsrParams.release);
+}
+
+void HowlingVoice::releaseParaphonicHold() {
+  // A held voice that is no longer gated fades out on its own envelope
+  if (paraphonicHold && isPlayingButReleased())
+    adsr.noteOff();
+
+  paraphonicHold = false;
 }
 
 void HowlingVoice::updateSampleParams(float tune, float sampleStart,
@@ -93,70 +155,446 @@ void HowlingVoice::setPan(float newPan) { pan = newPan; }
 void HowlingVoice::startNote(int midiNoteNumber, float velocity,
                              juce::SynthesiserSound *sound,
                              int currentPitchWheelPosition) {
-  // Check if it's Bass or One-Shot
-  isCurrentSoundBass = false;
-  isCurrentSoundOneShot = false;
+  juce::ignoreUnused(currentPitchWheelPosition);
 
-  if (auto *hs = dynamic_cast<HowlingSound *>(sound)) {
-    isCurrentSoundBass = hs->isBassSample();
-    isCurrentSoundOneShot = hs->isOneShotSample();
+  playingSound = dynamic_cast<const HowlingSound *>(sound);
+  if (playingSound == nullptr) {
+    jassertfalse; // canPlaySound only accepts HowlingSound
+    return;
   }
 
-  // 1. Base startNote
-  juce::SamplerVoice::startNote(midiNoteNumber, velocity, sound,
-                                currentPitchWheelPosition);
+  // Check if it's Bass or One-Shot
+  isCurrentSoundBass = playingSound->isBassSample();
+  isCurrentSoundOneShot = playingSound->isOneShotSample();
+
+  // 1. Playback position and pitch (same mapping as juce::SamplerVoice)
+  pitchRatio = std::pow(2.0, (midiNoteNumber - playingSound->getRootNote()) /
+                                 12.0) *
+               playingSound->getSourceSampleRate() / getSampleRate();
+  sourceSamplePosition = 0.0;
+  velocityGain = velocity;
 
   crossoverFilter.reset();
+  paraphonicHold = false;
 
   adsr.noteOn();
   filter.reset();
+  formants.reset();
   lfo.reset();
+  modPrimed = false;
+  inFastPath = false;
 }
 
 void HowlingVoice::stopNote(float velocity, bool allowTailOff) {
   // If One-Shot, IGNORE stopNote (let sample play to end)
-  // SamplerVoice naturally stops when sample data runs out (if not looping).
+  // renderNextBlock stops the voice when the sample data runs out.
   if (isCurrentSoundOneShot) {
     return;
   }
 
   if (allowTailOff) {
-    adsr.noteOff();
-    juce::SamplerVoice::stopNote(velocity, true);
+    // Last key lifted in paraphonic mode: ring out on the shared release
+    juce::ignoreUnused(velocity);
+    if (!(paraphonic && paraphonicHold))
+      adsr.noteOff();
+  } else {
+    stopImmediately();
+  }
+}
+
+void HowlingVoice::stopImmediately() {
+  adsr.reset();
+  clearCurrentNote();
+}
+
+int HowlingVoice::readSample(float *dest, int numSamples,
+                             const float *pitchMod) {
+  auto &data = *playingSound->getAudioData();
+  const float *const inL = data.getReadPointer(0);
+  const float *const inR =
+      data.getNumChannels() > 1 ? data.getReadPointer(1) : nullptr;
+  const double length = (double)playingSound->getLength();
+
+  // Prefetch what this block and the next will read. The head is locked in
+  // RAM; past it this hides cache (and TLB) misses behind the loop.
+  {
+    constexpr int floatsPerLine = 64 / (int)sizeof(float);
+    const int first = (int)sourceSamplePosition;
+    const int last = juce::jmin(
+        playingSound->getLength() + 1,
+        first + (int)(2.0 * numSamples * pitchRatio) + floatsPerLine);
+
+    for (int i = first; i < last; i += floatsPerLine) {
+      prefetchForRead(inL + i);
+      if (inR != nullptr)
+        prefetchForRead(inR + i);
+    }
+  }
+
+  // Mono voice: stereo samples are folded down like SamplerVoice does for a
+  // mono output. The sound keeps 4 guard samples, so pos + 1 is always valid.
+  for (int i = 0; i < numSamples; ++i) {
+    const auto pos = (int)sourceSamplePosition;
+    const auto alpha = (float)(sourceSamplePosition - pos);
+    const auto invAlpha = 1.0f - alpha;
+
+    float l = inL[pos] * invAlpha + inL[pos + 1] * alpha;
+    float r = (inR != nullptr) ? inR[pos] * invAlpha + inR[pos + 1] * alpha
+                               : l;
+
+    dest[i] = (l + r) * 0.5f * velocityGain;
+
+    sourceSamplePosition +=
+        pitchMod != nullptr ? pitchRatio * pitchMod[i] : pitchRatio;
+    if (sourceSamplePosition > length)
+      return i + 1;
+  }
+
+  return numSamples;
+}
+
+int HowlingVoice::getModulationMask() const {
+  if (modMatrix == nullptr)
+    return 0;
+
+  int allowed = ModulationMatrix::bit(ModulationMatrix::Destination::Pitch);
+  if (!paraphonic)
+    allowed |= ModulationMatrix::bit(ModulationMatrix::Destination::Cutoff) |
+               ModulationMatrix::bit(ModulationMatrix::Destination::Gain) |
+               ModulationMatrix::bit(ModulationMatrix::Destination::Pan);
+
+  return modMatrix->getDestinationMask() & allowed;
+}
+
+// Sample k (1-based) of the ramp is from + (to - from) * k / numSamples
+static void writeRamp(float *dest, int numSamples, float from, float to) {
+  const float step = (to - from) / (float)numSamples;
+  for (int i = 0; i < numSamples; ++i)
+    dest[i] = from + step * (float)(i + 1);
+}
+
+void HowlingVoice::renderModulation(int mask, const float *lfoValues,
+                                    const float *envValues, int numSamples,
+                                    const ModulationCurves &curves) {
+  using Matrix = ModulationMatrix;
+  constexpr int cutoff = (int)Matrix::Destination::Cutoff;
+  constexpr int gain = (int)Matrix::Destination::Gain;
+  constexpr int panIndex = (int)Matrix::Destination::Pan;
+  constexpr int pitch = (int)Matrix::Destination::Pitch;
+
+  float sources[Matrix::numSources] = {};
+  sources[(int)Matrix::Source::Velocity] = velocityGain;
+
+  // Matrix output at a sample, converted to the factors the voice applies
+  auto evaluate = [&](int index, float *point) {
+    if (lfoValues != nullptr)
+      sources[(int)Matrix::Source::Lfo] = lfoValues[index];
+    if (envValues != nullptr)
+      sources[(int)Matrix::Source::Envelope] = envValues[index];
+
+    float values[Matrix::numDestinations];
+    modMatrix->process(sources, values);
+
+    point[cutoff] = std::exp2(values[cutoff]);
+    point[gain] = juce::jmax(0.0f, 1.0f + values[gain]);
+    point[panIndex] = juce::jlimit(-1.0f, 1.0f, pan + values[panIndex]);
+    point[pitch] = std::exp2(values[pitch] / 12.0f);
+  };
+
+  // A new note starts from its own first value rather than ramping in
+  if (!modPrimed) {
+    evaluate(0, lastModPoint.data());
+    modPrimed = true;
+  }
+
+  curves.panPoints[0] = lastModPoint[panIndex];
+  int chunk = 0;
+
+  for (int pos = 0; pos < numSamples;
+       pos += Matrix::controlInterval, ++chunk) {
+    const int len = juce::jmin(Matrix::controlInterval, numSamples - pos);
+
+    float point[Matrix::numDestinations];
+    evaluate(pos + len - 1, point);
+
+    if (mask & Matrix::bit(Matrix::Destination::Cutoff))
+      writeRamp(curves.cutoff + pos, len, lastModPoint[cutoff],
+                point[cutoff]);
+    if (mask & Matrix::bit(Matrix::Destination::Gain))
+      writeRamp(curves.gain + pos, len, lastModPoint[gain], point[gain]);
+    if (mask & Matrix::bit(Matrix::Destination::Pitch))
+      writeRamp(curves.pitch + pos, len, lastModPoint[pitch],
+                point[pitch]);
+    curves.panPoints[chunk + 1] = point[panIndex];
+
+    std::copy(point, point + Matrix::numDestinations, lastModPoint.begin());
+  }
+}
+
+static void getPanGains(float panPosition, float &left, float &right) {
+  const float panRad =
+      (panPosition + 1.0f) * juce::MathConstants<float>::pi * 0.25f;
+  left = std::cos(panRad);
+  right = std::sin(panRad);
+}
+
+void HowlingVoice::addPanned(juce::AudioBuffer<float> &outputBuffer,
+                             int startSample, const float *source,
+                             int numSamples, const float *panPoints) {
+  if (outputBuffer.getNumChannels() != 2) {
+    for (int ch = 0; ch < outputBuffer.getNumChannels(); ++ch)
+      outputBuffer.addFrom(ch, startSample, source, numSamples);
+    return;
+  }
+
+  float left, right;
+
+  if (panPoints == nullptr) {
+    getPanGains(pan, left, right);
+    outputBuffer.addFrom(0, startSample, source, numSamples, left);
+    outputBuffer.addFrom(1, startSample, source, numSamples, right);
+    return;
+  }
+
+  // Ramp the channel gains from one control point to the next
+  getPanGains(panPoints[0], left, right);
+  int chunk = 0;
+
+  for (int pos = 0; pos < numSamples;
+       pos += ModulationMatrix::controlInterval, ++chunk) {
+    const int len =
+        juce::jmin(ModulationMatrix::controlInterval, numSamples - pos);
+
+    float nextLeft, nextRight;
+    getPanGains(panPoints[chunk + 1], nextLeft, nextRight);
+
+    outputBuffer.addFromWithRamp(0, startSample + pos, source + pos, len, left,
+                                 nextLeft);
+    outputBuffer.addFromWithRamp(1, startSample + pos, source + pos, len,
+                                 right, nextRight);
+
+    left = nextLeft;
+    right = nextRight;
+  }
+}
+
+bool HowlingVoice::isFilterBypassed(int modMask) const {
+  // Paraphonic voices are filtered on the bus. Otherwise an unmodulated
+  // lowpass at the top of the range with no resonant peak counts as open,
+  // and neither render path runs it.
+  if (paraphonic)
+    return true;
+
+  const bool cutoffMod =
+      modMask & ModulationMatrix::bit(ModulationMatrix::Destination::Cutoff);
+  return currentFilterType == 0 && !cutoffMod && baseCutoff >= 20000.0f &&
+         FilterProcessor::resonanceToQ(baseResonance) <=
+             juce::MathConstants<float>::sqrt2 * 0.5f;
+}
+
+bool HowlingVoice::canUseFastPath(int modMask) const {
+  return isCurrentSoundOneShot && !isCurrentSoundBass && modMask == 0 &&
+         isFilterBypassed(modMask) && pitchRatio == 1.0 &&
+         sourceSamplePosition == std::floor(sourceSamplePosition);
+}
+
+bool HowlingVoice::hasFinished(bool sampleFinished) {
+  // The voice ends once its envelope is done, the sample has run out (this
+  // is what stops One-Shots), or a held paraphonic voice's shared release
+  // has finished. The samples rendered up to that point are still mixed.
+  bool finished = !adsr.isActive() || sampleFinished;
+
+  if (paraphonic && paraphonicHold && isPlayingButReleased() &&
+      sharedEnvelope != nullptr && !sharedEnvelope->isActive()) {
+    paraphonicHold = false;
+    finished = true;
+  }
+
+  return finished;
+}
+
+void HowlingVoice::renderFastPath(juce::AudioBuffer<float> &outputBuffer,
+                                  int startSample, int numSamples) {
+  inFastPath = true;
+
+  auto &data = *playingSound->getAudioData();
+  const int pos = (int)sourceSamplePosition;
+
+  // Same end point as readSample, which stops after reading index length
+  const int available = juce::jmax(0, playingSound->getLength() - pos + 1);
+  const int numToCopy = juce::jmin(numSamples, available);
+
+  // readSample folds stereo to mono as (l + r) * 0.5
+  const bool stereoSource = data.getNumChannels() > 1;
+  const float gain = velocityGain * (stereoSource ? 0.5f : 1.0f);
+
+  float left = 1.0f, right = 1.0f;
+  if (outputBuffer.getNumChannels() == 2)
+    getPanGains(pan, left, right);
+
+  // Envelope moving: rendered into scratch (if the arena is full it holds
+  // its level for this block instead)
+  jassert(scratch != nullptr);
+  ScratchArena::ScopedRewind rewind(*scratch);
+  float *env = nullptr;
+  float *mono = nullptr;
+  if (!adsr.isSustaining()) {
+    env = scratch->allocate(numSamples);
+    mono = scratch->allocate(numSamples);
+  }
+
+  if (env == nullptr || mono == nullptr) {
+    // Flat envelope: one gain per channel straight from the sample data
+    const float level = gain * adsr.getCurrentValue();
+
+    for (int ch = 0; ch < outputBuffer.getNumChannels(); ++ch) {
+      auto *out = outputBuffer.getWritePointer(ch, startSample);
+      const float channelGain = level * (ch == 1 ? right : left);
+
+      juce::FloatVectorOperations::addWithMultiply(
+          out, data.getReadPointer(0, pos), channelGain, numToCopy);
+      if (stereoSource)
+        juce::FloatVectorOperations::addWithMultiply(
+            out, data.getReadPointer(1, pos), channelGain, numToCopy);
+    }
   } else {
-    adsr.reset();
-    juce::SamplerVoice::stopNote(velocity, false);
+    // Attack, decay or release: the source times the envelope once, then
+    // one gain per channel
+    adsr.render(env, numSamples);
+
+    juce::FloatVectorOperations::multiply(mono, data.getReadPointer(0, pos),
+                                          env, numToCopy);
+    if (stereoSource)
+      juce::FloatVectorOperations::addWithMultiply(
+          mono, data.getReadPointer(1, pos), env, numToCopy);
+
+    for (int ch = 0; ch < outputBuffer.getNumChannels(); ++ch)
+      juce::FloatVectorOperations::addWithMultiply(
+          outputBuffer.getWritePointer(ch, startSample), mono,
+          gain * (ch == 1 ? right : left), numToCopy);
   }
+
+  sourceSamplePosition += numToCopy;
+
+  if (hasFinished(numToCopy < numSamples))
+    clearCurrentNote();
 }
 
 void HowlingVoice::renderNextBlock(juce::AudioBuffer<float> &outputBuffer,
                                    int startSample, int numSamples) {
-  if (!isVoiceActive())
+  if (!isVoiceActive() || playingSound == nullptr)
     return;
 
-  if (tempBuffer.getNumSamples() < numSamples) {
-    tempBuffer.setSize(1, numSamples, false, false, true);
+  const int modMask = getModulationMask();
+
+  if (canUseFastPath(modMask)) {
+    renderFastPath(outputBuffer, startSample, numSamples);
+    return;
   }
-  tempBuffer.clear();
 
-  // 1. Render Raw Sample
-  juce::SamplerVoice::renderNextBlock(tempBuffer, 0, numSamples);
+  // Back on the full path, or the filter back in: it has not seen the
+  // skipped samples
+  const bool filterBypassed = isFilterBypassed(modMask);
+  if (inFastPath || (wasFilterBypassed && !filterBypassed)) {
+    inFastPath = false;
+    filter.reset();
+    formants.reset();
+  }
+  wasFilterBypassed = filterBypassed;
 
-  // 2. ADSR
-  adsr.applyEnvelopeToBuffer(tempBuffer, 0, numSamples);
+  // Everything below is scratch for this call only; the next voice reuses
+  // the same (still cached) memory
+  jassert(scratch != nullptr);
+  ScratchArena::ScopedRewind rewind(*scratch);
+  auto *bufferData = scratch->allocate(numSamples); // Mono voice
 
-  auto *bufferData = tempBuffer.getWritePointer(0);
+  // 1. Modulation sources, only the ones some active route reads
+  using Matrix = ModulationMatrix;
+  const bool cutoffMod = modMask & Matrix::bit(Matrix::Destination::Cutoff);
+  const bool gainMod = modMask & Matrix::bit(Matrix::Destination::Gain);
+  const bool panMod = modMask & Matrix::bit(Matrix::Destination::Pan);
+  const bool pitchMod = modMask & Matrix::bit(Matrix::Destination::Pitch);
 
-  // 3. Filter Processing
-  for (int i = 0; i < numSamples; ++i) {
-    float lfoValue = lfo.processSample(0.0f);
+  const bool lfoIsSource =
+      modMask != 0 && modMatrix->feeds(Matrix::Source::Lfo, modMask);
+  float *lfoBuffer = nullptr;
+  if (lfoIsSource && sharedLfo == nullptr)
+    lfoBuffer = scratch->allocate(numSamples);
 
-    float modFactor = std::pow(2.0f, lfoValue * lfoDepth * 2.0f);
-    float modCutoff = baseCutoff * modFactor;
-    modCutoff = juce::jlimit(20.0f, 20000.0f, modCutoff);
+  const bool envIsSource =
+      modMask != 0 && modMatrix->feeds(Matrix::Source::Envelope, modMask);
+  float *envBuffer = nullptr;
+  if (envIsSource)
+    envBuffer = scratch->allocate(numSamples);
 
-    filter.setCutoffFrequency(modCutoff);
-    filter.setResonance(baseResonance);
+  ModulationCurves curves;
+  if (cutoffMod)
+    curves.cutoff = scratch->allocate(numSamples);
+  if (gainMod)
+    curves.gain = scratch->allocate(numSamples);
+  if (pitchMod)
+    curves.pitch = scratch->allocate(numSamples);
+  if (panMod)
+    curves.panPoints = scratch->allocate(
+        numSamples / ModulationMatrix::controlInterval + 2);
+
+  float *highs = nullptr; // Bass split, below
+  if (isCurrentSoundBass)
+    highs = scratch->allocate(numSamples);
+
+  // Arena full: the voice sits this block out where it is
+  if (scratch->hasOverflowed())
+    return;
+
+  const float *lfoValues = nullptr;
+  if (lfoBuffer != nullptr) {
+    lfo.renderBlock(lfoBuffer, numSamples);
+    lfoValues = lfoBuffer;
+  } else if (lfoIsSource) {
+    lfoValues = sharedLfo + startSample;
+  }
+
+  if (envIsSource)
+    adsr.render(envBuffer, numSamples);
+
+  if (modMask != 0)
+    renderModulation(modMask, lfoValues, envBuffer, numSamples, curves);
+
+  // 2. Render Raw Sample
+  const int rendered = readSample(bufferData, numSamples, curves.pitch);
+  const bool sampleFinished = rendered < numSamples;
+  if (sampleFinished)
+    juce::FloatVectorOperations::clear(bufferData + rendered,
+                                       numSamples - rendered);
+
+  // 3. ADSR (the only envelope on this voice, one multiply pass)
+  if (envIsSource)
+    juce::FloatVectorOperations::multiply(bufferData, envBuffer, numSamples);
+  else
+    adsr.apply(bufferData, numSamples);
+
+  if (gainMod)
+    juce::FloatVectorOperations::multiply(bufferData, curves.gain,
+                                          numSamples);
+
+  // 4. Filter Processing (paraphonic voices are filtered on the shared bus).
+  // The formant bank has no cutoff and takes the whole block at once.
+  const bool formant = currentFilterType == formantType && !paraphonic;
+  if (formant) {
+    formants.process(&bufferData, 1, numSamples);
+
+    // Safety Check for NaN/Infinity: anything bad ends up in the last sample
+    if (numSamples > 0 && !std::isfinite(bufferData[numSamples - 1])) {
+      juce::FloatVectorOperations::clear(bufferData, numSamples);
+      formants.reset();
+    }
+  }
+
+  // Unmodulated, the cutoff set in updateFilter holds for the whole block.
+  for (int i = 0; i < numSamples && !filterBypassed && !formant; ++i) {
+    if (cutoffMod)
+      filter.setCutoffFrequency(
+          juce::jlimit(20.0f, 20000.0f, baseCutoff * curves.cutoff[i]));
 
     float input = bufferData[i];
     if (std::isnan(input))
@@ -176,62 +614,38 @@ void HowlingVoice::renderNextBlock(juce::AudioBuffer<float> &outputBuffer,
     bufferData[i] = filtered;
   }
 
-  if (!adsr.isActive()) {
-    clearCurrentNote();
-    return;
-  }
+  const bool shouldStop = hasFinished(sampleFinished);
 
-  // FORCE STOP if One-Shot and Sample has finished playing
-  // SamplerVoice::isVoiceActive() returns false when sample finishes (if not
-  // looping)
-  if (isCurrentSoundOneShot && !juce::SamplerVoice::isVoiceActive()) {
-    clearCurrentNote();
-    return;
-  }
-
-  // 4. Panning and Output Mix
+  // 5. Panning and Output Mix
   if (isCurrentSoundBass) {
     // Bass Logic: Lows (<120Hz) -> Mono, Highs -> Panned
 
     // We can't easily do per-sample crossover efficiently here without
     // block processing or another temp buffer, but LinkwitzRiley is per-sample
     // capable. However, L-R is usually 2 channels (stereo). Here we have mono
-    // voice signal `tempBuffer`. We want to split it: Lows, Highs.
+    // voice signal `bufferData`. We want to split it: Lows, Highs.
 
     // Process the whole block through a filter to get Lows?
     // But filters are stateful.
 
-    // Let's use two filters? Or process tempBuffer in place for Lows,
+    // Let's use two filters? Or process bufferData in place for Lows,
     // and subtract from original to get Highs?
     // (Linkwitz-Riley sums flat).
 
-    // Create a copy for Highs
-    juce::AudioBuffer<float> highBuffer;
-    highBuffer.makeCopyOf(tempBuffer);
+    // Copy for Highs (scratch, no allocation)
+    juce::FloatVectorOperations::copy(highs, bufferData, numSamples);
 
-    // Process tempBuffer (Lows)
-    juce::dsp::AudioBlock<float> block(tempBuffer);
-    // Since we only have 1 channel in tempBuffer
+    // Process bufferData (Lows)
+    juce::dsp::AudioBlock<float> block(&bufferData, 1, (size_t)numSamples);
     juce::dsp::ProcessContextReplacing<float> context(block);
     crossoverFilter.process(context);
 
-    // Now tempBuffer contains Lows.
-    // Highs = Original (highBuffer) - Lows (tempBuffer)
-    highBuffer.addFrom(0, 0, tempBuffer.getReadPointer(0), numSamples,
-                       -1.0f); // Subtract
+    // Now bufferData contains Lows.
+    // Highs = Original (highs) - Lows (bufferData)
+    juce::FloatVectorOperations::subtract(highs, bufferData, numSamples);
 
     // Mix to Output
     for (int ch = 0; ch < outputBuffer.getNumChannels(); ++ch) {
-      // Pan Highs
-      float panGain = 1.0f;
-      if (outputBuffer.getNumChannels() == 2) {
-        float panRad = (pan + 1.0f) * juce::MathConstants<float>::pi * 0.25f;
-        if (ch == 0)
-          panGain = std::cos(panRad);
-        if (ch == 1)
-          panGain = std::sin(panRad);
-      }
-
       // Mono Lows (Center panned -> equal gain 0.707 or 1.0 depending on law,
       // let's use 1.0 for kick/sub power)
       float bassGain = 1.0f;
@@ -242,28 +656,19 @@ void HowlingVoice::renderNextBlock(juce::AudioBuffer<float> &outputBuffer,
       bassGain = (outputBuffer.getNumChannels() == 2) ? 0.707f : 1.0f;
 
       // Add Lows (Center)
-      outputBuffer.addFrom(ch, startSample, tempBuffer, 0, 0, numSamples,
-                           bassGain);
-
-      // Add Highs (Panned)
-      outputBuffer.addFrom(ch, startSample, highBuffer, 0, 0, numSamples,
-                           panGain);
+      outputBuffer.addFrom(ch, startSample, bufferData, numSamples, bassGain);
     }
+
+    // Add Highs (Panned)
+    addPanned(outputBuffer, startSample, highs, numSamples, curves.panPoints);
   } else {
     // Standard processing
-    for (int ch = 0; ch < outputBuffer.getNumChannels(); ++ch) {
-      float gain = 1.0f;
-      if (outputBuffer.getNumChannels() == 2) {
-        float panRad = (pan + 1.0f) * juce::MathConstants<float>::pi * 0.25f;
-        if (ch == 0)
-          gain = std::cos(panRad);
-        if (ch == 1)
-          gain = std::sin(panRad);
-      }
-
-      outputBuffer.addFrom(ch, startSample, tempBuffer, 0, 0, numSamples, gain);
-    }
+    addPanned(outputBuffer, startSample, bufferData, numSamples,
+              curves.panPoints);
   }
+
+  if (shouldStop)
+    clearCurrentNote();
 }
 
 //==============================================================================
@@ -271,24 +676,246 @@ void HowlingVoice::renderNextBlock(juce::AudioBuffer<float> &outputBuffer,
 //==============================================================================
 
 SynthEngine::SynthEngine() {
-  // Add voices
-  for (int i = 0; i < 8; ++i) {
-    addVoice(new HowlingVoice());
-  }
+  globalLfo.setDepth(1.0f); // Depth is applied by the modulation matrix
+
+  lastSentControls.fill(-1);
+  dirtyControls.reserve(pendingControls.size());
 }
 
 void SynthEngine::initialize() {
   // Clears sounds and voices? No, just sounds.
-  clearSounds();
+  releaseSounds();
+}
+
+void SynthEngine::releaseSounds() {
+  juce::ReferenceCountedArray<juce::SynthesiserSound> released;
+  {
+    const juce::ScopedLock sl(lock);
+    for (auto *voice : voices)
+      if (auto *howlingVoice = dynamic_cast<HowlingVoice *>(voice))
+        howlingVoice->stopImmediately();
+
+    released.swapWith(sounds);
+  }
+
+  // The sounds go here, once the audio thread can run again
+  released.clear();
+}
+
+void SynthEngine::createVoices() {
+  for (int i = 0; i < numVoices; ++i) {
+    auto *voice = new HowlingVoice();
+    voice->setModulationMatrix(&modMatrix);
+    voice->setScratchArena(scratch);
+    if (paraphonic)
+      voice->setParaphonic(true, &paraphonicEnvelope);
+    addVoice(voice);
+  }
 }
 
 void SynthEngine::prepare(double sampleRate, int samplesPerBlock) {
+  if (getNumVoices() == 0)
+    createVoices();
+
   setCurrentPlaybackSampleRate(sampleRate);
   for (int i = 0; i < getNumVoices(); ++i) {
     if (auto *voice = dynamic_cast<HowlingVoice *>(getVoice(i))) {
       voice->prepare(sampleRate, samplesPerBlock);
     }
   }
+
+  globalLfo.prepare(sampleRate);
+
+  paraphonicEnvelope.setSampleRate(sampleRate);
+  paraphonicEnvelope.reset();
+  paraphonicGateOpen = false;
+  busEnvelopePoints.assign(
+      (size_t)(samplesPerBlock / ModulationMatrix::controlInterval + 1), 0.0f);
+
+  // ~1ms grain, rounded up to a power of two (64 samples at 44.1/48k)
+  setRenderGrain(juce::nextPowerOfTwo((int)(sampleRate * 0.001)), true);
+
+  // Room for a dense block of events so addEvent never reallocates
+  batchedMidi.ensureSize(4096);
+  lastSentControls.fill(-1);
+  for (auto &pending : pendingControls)
+    pending = {};
+  dirtyControls.clear();
+}
+
+void SynthEngine::setRenderGrain(int minSubBlockSamples,
+                                 bool quantizeControllers) {
+  renderGrain = juce::jmax(1, minSubBlockSamples);
+  snapControllersToGrain = quantizeControllers;
+
+  // Non-strict: the first event of a block still lands sample-accurately
+  setMinimumRenderingSubdivisionSize(renderGrain, false);
+}
+
+void SynthEngine::renderBlock(juce::AudioBuffer<float> &outputBuffer,
+                              juce::MidiBuffer &midiMessages, int numSamples) {
+  jassert(scratch != nullptr);
+
+  // The shared LFO block lives in scratch memory until the voices are done
+  ScratchArena::ScopedRewind rewind(*scratch);
+
+  coalesceControllers(midiMessages);
+  renderGlobalLfo(numSamples);
+  renderNextBlock(outputBuffer, midiMessages, 0, numSamples);
+}
+
+bool SynthEngine::hasActiveVoices() const {
+  for (auto *voice : voices)
+    if (voice->isVoiceActive())
+      return true;
+  return false;
+}
+
+void SynthEngine::skipBlock(int numSamples) {
+  if (!lfoRetrigger)
+    globalLfo.advance(numSamples);
+
+  // The bus filter may still be ringing out
+  std::fill(busEnvelopePoints.begin(), busEnvelopePoints.end(),
+            paraphonicEnvelope.getCurrentValue());
+}
+
+float SynthEngine::getBusCutoffOctaves(int samplePosition) const {
+  if (envCutoffAmount == 0.0f && velCutoffAmount == 0.0f)
+    return 0.0f;
+
+  const auto point = juce::jmin(
+      (size_t)(samplePosition / ModulationMatrix::controlInterval),
+      busEnvelopePoints.size() - 1);
+  return (envCutoffAmount * busEnvelopePoints[point] +
+          velCutoffAmount * paraphonicVelocity) *
+         ModulationMatrix::cutoffOctaves;
+}
+
+void SynthEngine::renderGlobalLfo(int numSamples) {
+  // Only rendered when a voice route reads the LFO (paraphonic voices only
+  // take pitch)
+  const int voiceMask =
+      paraphonic ? ModulationMatrix::bit(ModulationMatrix::Destination::Pitch)
+                 : modMatrix.getDestinationMask();
+  const bool share = !lfoRetrigger &&
+                     modMatrix.feeds(ModulationMatrix::Source::Lfo, voiceMask);
+
+  // With the arena full each voice falls back to its own LFO
+  float *values = share ? scratch->allocate(numSamples) : nullptr;
+  if (values != nullptr)
+    globalLfo.renderBlock(values, numSamples);
+  else if (share)
+    globalLfo.advance(numSamples);
+
+  for (int i = 0; i < getNumVoices(); ++i) {
+    if (auto *voice = dynamic_cast<HowlingVoice *>(getVoice(i)))
+      voice->setSharedLfo(values);
+  }
+}
+
+void SynthEngine::setScratchArena(ScratchArena *arena) {
+  scratch = arena;
+
+  for (int i = 0; i < getNumVoices(); ++i) {
+    if (auto *voice = dynamic_cast<HowlingVoice *>(getVoice(i)))
+      voice->setScratchArena(arena);
+  }
+}
+
+// Controllers whose order relative to other events carries meaning (bank
+// select, data entry, (N)RPN, pedals, channel mode) are never merged or moved.
+static bool isContinuousController(int cc) {
+  if (cc == 0 || cc == 32 || cc == 6 || cc == 38)
+    return false;
+  return cc < 64 || (cc >= 70 && cc < 96);
+}
+
+void SynthEngine::coalesceControllers(juce::MidiBuffer &midiMessages) {
+  if (midiMessages.isEmpty())
+    return;
+
+  batchedMidi.clear();
+  int currentCell = -1;
+
+  for (const auto metadata : midiMessages) {
+    const auto msg = metadata.getMessage();
+    const int cell = metadata.samplePosition / renderGrain;
+
+    if (cell != currentCell) {
+      flushPendingControllers(currentCell * renderGrain);
+      currentCell = cell;
+    }
+
+    int slot = -1;
+    int value = 0;
+
+    if (msg.isController() &&
+        isContinuousController(msg.getControllerNumber())) {
+      slot = msg.getControllerNumber();
+      value = msg.getControllerValue();
+    } else if (msg.isPitchWheel()) {
+      slot = pitchWheelSlot;
+      value = msg.getPitchWheelValue();
+    } else if (msg.isChannelPressure()) {
+      slot = pressureSlot;
+      value = msg.getChannelPressureValue();
+    }
+
+    if (slot < 0) {
+      // Notes and everything else pass through untouched
+      batchedMidi.addEvent(metadata.data, metadata.numBytes,
+                           metadata.samplePosition);
+      continue;
+    }
+
+    // Only the last value per controller within a grain cell survives
+    const int index = (msg.getChannel() - 1) * numControlSlots + slot;
+    auto &pending = pendingControls[(size_t)index];
+    if (pending.samplePosition < 0)
+      dirtyControls.push_back(index);
+
+    pending.value = value;
+    pending.samplePosition = metadata.samplePosition;
+  }
+
+  flushPendingControllers(currentCell * renderGrain);
+
+  // Copied back rather than swapped, so the storage sized in prepare stays
+  // with batchedMidi
+  midiMessages.clear();
+  midiMessages.addEvents(batchedMidi, 0, -1, 0);
+}
+
+void SynthEngine::flushPendingControllers(int cellStart) {
+  for (auto index : dirtyControls) {
+    auto &pending = pendingControls[(size_t)index];
+    const int channel = index / numControlSlots + 1;
+    const int slot = index % numControlSlots;
+    const int position =
+        snapControllersToGrain ? cellStart : pending.samplePosition;
+
+    // Drop values the synth has already seen
+    if (pending.value != lastSentControls[(size_t)index]) {
+      if (slot == pitchWheelSlot)
+        batchedMidi.addEvent(
+            juce::MidiMessage::pitchWheel(channel, pending.value), position);
+      else if (slot == pressureSlot)
+        batchedMidi.addEvent(
+            juce::MidiMessage::channelPressureChange(channel, pending.value),
+            position);
+      else
+        batchedMidi.addEvent(
+            juce::MidiMessage::controllerEvent(channel, slot, pending.value),
+            position);
+
+      lastSentControls[(size_t)index] = pending.value;
+    }
+
+    pending = {};
+  }
+
+  dirtyControls.clear();
 }
 
 // ... (existing updateSampleParams)
@@ -303,14 +930,159 @@ void SynthEngine::updateSampleParams(float tune, float sampleStart,
 
 void SynthEngine::updateParams(float attack, float decay, float sustain,
                                float release, float cutoff, float resonance,
-                               int filterType, float lfoRate, float lfoDepth) {
+                               int filterType, float vowel, float lfoRate,
+                               float lfoDepth) {
   for (int i = 0; i < getNumVoices(); ++i) {
     if (auto *voice = dynamic_cast<HowlingVoice *>(getVoice(i))) {
       voice->updateADSR(attack, decay, sustain, release);
-      voice->updateFilter(cutoff, resonance, filterType);
-      voice->updateLFO(lfoRate, lfoDepth);
+      voice->updateFilter(cutoff, resonance, filterType, vowel);
+      voice->updateLFO(lfoRate, lfoWaveform);
     }
   }
+
+  globalLfo.setRate(lfoRate);
+  globalLfo.setWaveform(lfoWaveform);
+
+  // Fixed routes for now; compile() is a no-op unless one of them changed
+  using Matrix = ModulationMatrix;
+  modMatrix.setSlot(0, Matrix::Source::Lfo, (Matrix::Destination)lfoTarget,
+                    lfoDepth);
+  modMatrix.setSlot(1, Matrix::Source::Envelope, Matrix::Destination::Cutoff,
+                    envCutoffAmount);
+  modMatrix.setSlot(2, Matrix::Source::Velocity, Matrix::Destination::Cutoff,
+                    velCutoffAmount);
+  modMatrix.compile();
+
+  paraphonicEnvelope.setParameters({attack, decay, sustain, release});
+}
+
+void SynthEngine::setModulation(int lfoWave, int newLfoTarget,
+                                float envToCutoff, float velToCutoff) {
+  lfoWaveform = (LFOProcessor::Waveform)juce::jlimit(0, 2, lfoWave);
+  lfoTarget = juce::jlimit(0, ModulationMatrix::numDestinations - 1,
+                           newLfoTarget);
+  envCutoffAmount = envToCutoff;
+  velCutoffAmount = velToCutoff;
+}
+
+void SynthEngine::setEnvelopeCurve(EnvelopeGenerator::Curve curve) {
+  for (int i = 0; i < getNumVoices(); ++i) {
+    if (auto *voice = dynamic_cast<HowlingVoice *>(getVoice(i)))
+      voice->setEnvelopeCurve(curve);
+  }
+
+  paraphonicEnvelope.setCurve(curve);
+}
+
+void SynthEngine::setParaphonic(bool shouldBeParaphonic) {
+  if (paraphonic == shouldBeParaphonic)
+    return;
+
+  paraphonic = shouldBeParaphonic;
+  paraphonicEnvelope.reset();
+  paraphonicGateOpen = false;
+
+  for (int i = 0; i < getNumVoices(); ++i) {
+    if (auto *voice = dynamic_cast<HowlingVoice *>(getVoice(i)))
+      voice->setParaphonic(paraphonic, &paraphonicEnvelope);
+  }
+
+  updateParaphonicGate();
+}
+
+int SynthEngine::countGatedVoices(int excludingNote) const {
+  int gated = 0;
+  for (auto *voice : voices) {
+    if (voice->isVoiceActive() && !voice->isPlayingButReleased() &&
+        voice->getCurrentlyPlayingNote() != excludingNote)
+      ++gated;
+  }
+  return gated;
+}
+
+void SynthEngine::updateParaphonicGate() {
+  if (!paraphonic)
+    return;
+
+  const bool anyGated = countGatedVoices(-1) > 0;
+
+  if (anyGated && !paraphonicGateOpen) {
+    // New phrase: voices still ringing on the old release fade out
+    for (int i = 0; i < getNumVoices(); ++i) {
+      if (auto *voice = dynamic_cast<HowlingVoice *>(getVoice(i)))
+        voice->releaseParaphonicHold();
+    }
+    paraphonicEnvelope.noteOn();
+    paraphonicGateOpen = true;
+  } else if (!anyGated && paraphonicGateOpen) {
+    paraphonicEnvelope.noteOff();
+    paraphonicGateOpen = false;
+  }
+}
+
+void SynthEngine::noteOff(int midiChannel, int midiNoteNumber, float velocity,
+                          bool allowTailOff) {
+  if (paraphonic) {
+    // The last gated key hands its voice over to the shared release
+    const bool isLastKey = countGatedVoices(midiNoteNumber) == 0;
+    for (int i = 0; i < getNumVoices(); ++i) {
+      if (auto *voice = dynamic_cast<HowlingVoice *>(getVoice(i)))
+        voice->setParaphonicHold(isLastKey);
+    }
+  }
+
+  juce::Synthesiser::noteOff(midiChannel, midiNoteNumber, velocity,
+                             allowTailOff);
+  updateParaphonicGate();
+}
+
+void SynthEngine::handleSustainPedal(int midiChannel, bool isDown) {
+  if (paraphonic && !isDown) {
+    // Pedal up releases every voice whose key is already lifted
+    int stillHeld = 0;
+    for (auto *voice : voices) {
+      if (voice->isVoiceActive() && voice->isKeyDown())
+        ++stillHeld;
+    }
+    for (int i = 0; i < getNumVoices(); ++i) {
+      if (auto *voice = dynamic_cast<HowlingVoice *>(getVoice(i)))
+        voice->setParaphonicHold(stillHeld == 0);
+    }
+  }
+
+  juce::Synthesiser::handleSustainPedal(midiChannel, isDown);
+  updateParaphonicGate();
+}
+
+void SynthEngine::renderVoices(juce::AudioBuffer<float> &outputAudio,
+                               int startSample, int numSamples) {
+  juce::Synthesiser::renderVoices(outputAudio, startSample, numSamples);
+
+  // The output only holds the voice sum at this point, so the shared
+  // envelope can be applied sample-accurately per sub-block
+  if (!paraphonic)
+    return;
+
+  if (envCutoffAmount == 0.0f || busEnvelopePoints.empty()) {
+    paraphonicEnvelope.applyEnvelopeToBuffer(outputAudio, startSample,
+                                             numSamples);
+    return;
+  }
+
+  // Envelope to cutoff: note the level at each control point on the way,
+  // for the bus filter
+  constexpr int interval = ModulationMatrix::controlInterval;
+  const int end = startSample + numSamples;
+  for (int pos = startSample; pos < end;) {
+    const int pointEnd = juce::jmin(end, (pos / interval + 1) * interval);
+    if (pos % interval == 0) {
+      const auto point =
+          juce::jmin((size_t)(pos / interval), busEnvelopePoints.size() - 1);
+      busEnvelopePoints[point] = paraphonicEnvelope.getCurrentValue();
+    }
+    paraphonicEnvelope.applyEnvelopeToBuffer(outputAudio, pos, pointEnd - pos);
+    pos = pointEnd;
+  }
 }
 
 void SynthEngine::setPackMode(int size, float spread) {
@@ -332,4 +1104,8 @@ void SynthEngine::noteOn(int midiChannel, int midiNoteNumber, float velocity) {
   } else {
     juce::Synthesiser::noteOn(midiChannel, midiNoteNumber, velocity);
   }
+
+  if (paraphonic)
+    paraphonicVelocity = velocity;
+  updateParaphonicGate();
 }
@@ -1,5 +1,12 @@
 #pragma once
 
+#include "EnvelopeGenerator.h"
+#include "FilterProcessor.h"
+#include "FormantBank.h"
+#include "LFOProcessor.h"
+#include "MemoryLock.h"
+#include "ModulationMatrix.h"
+#include "ScratchArena.h"
 #include <JuceHeader.h>
 
 //==============================================================================
@@ -7,6 +14,12 @@
     A sound that holds the sample data.
     Wrapper around juce::SamplerSound to allow for custom expansion if needed,
     and to maintain the "HowlingSound" type name used in the codebase.
+    Keeps its own copy of the playback info SamplerSound hides from
+    subclasses, since HowlingVoice does its own sample playback.
+    The head of the sample data is locked in RAM so a note-on never takes
+    a page fault on the audio thread. Unlocking takes a global lock and a
+    syscall, so a sound must never die on the audio thread: drop sounds
+    through SynthEngine::releaseSounds, not clearSounds.
 */
 class HowlingSound : public juce::SamplerSound {
 public:
@@ -18,33 +31,73 @@ public:
       : juce::SamplerSound(name, source, midiNotes, midiNoteForNormalPitch,
                            attackTimeSecs, releaseTimeSecs,
                            maxSampleLengthSeconds),
-        isBass(isBassSound), isOneShot(isOneShotSound) {}
+        isBass(isBassSound), isOneShot(isOneShotSound),
+        rootNote(midiNoteForNormalPitch), sourceSampleRate(source.sampleRate) {
+    // Same length SamplerSound reads (it stores length + 4 guard samples)
+    if (sourceSampleRate > 0 && source.lengthInSamples > 0)
+      length = juce::jmin((int)source.lengthInSamples,
+                          (int)(maxSampleLengthSeconds * sourceSampleRate));
+
+    lockHead();
+  }
 
   bool isBassSample() const { return isBass; }
   bool isOneShotSample() const { return isOneShot; }
 
+  int getRootNote() const { return rootNote; }
+  double getSourceSampleRate() const { return sourceSampleRate; }
+  int getLength() const { return length; }
+
+  // Appends the pages of this sound pinned in RAM (none if the OS refused
+  // the lock)
+  void addLockedPages(std::vector<MemoryLock::PageRange> &pages) const;
+
+  static constexpr double lockedHeadSeconds = 0.5;
+
 private:
+  void lockHead();
+
   bool isBass;
   bool isOneShot;
+  int rootNote;
+  double sourceSampleRate;
+  int length = 0;
+  std::vector<std::unique_ptr<MemoryLock>> headLocks; // One per channel
 };
 
 //==============================================================================
 /**
     A voice that plays back the HowlingSound (Sample).
-    Inherits from juce::SamplerVoice to handle pitch shifting and resampling.
-    Adds custom Filter and LFO processing.
+    Does its own resampling (same linear interpolation as juce::SamplerVoice)
+    so there is exactly one amplitude envelope per voice, applied in a single
+    block pass. Adds custom Filter and LFO processing; modulation is
+    evaluated at control rate and interpolated per sample.
 */
-class HowlingVoice : public juce::SamplerVoice {
+class HowlingVoice : public juce::SynthesiserVoice {
 public:
   HowlingVoice();
 
   bool canPlaySound(juce::SynthesiserSound *sound) override {
-    return dynamic_cast<juce::SamplerSound *>(sound) != nullptr;
+    return dynamic_cast<HowlingSound *>(sound) != nullptr;
   }
 
+  void pitchWheelMoved(int /*newValue*/) override {}
+  void controllerMoved(int /*controllerNumber*/, int /*newValue*/) override {}
+
   // DSP Parameters
-  void updateFilter(float cutoff, float resonance, int filterType);
-  void updateLFO(float rate, float depth);
+  void updateFilter(float cutoff, float resonance, int filterType,
+                    float vowel);
+  void updateLFO(float rate, LFOProcessor::Waveform waveform);
+  // Block of LFO values shared by all voices (global mode), indexed by the
+  // same sample positions as the output buffer. nullptr means the voice runs
+  // its own LFO, restarted on every note (retrigger mode).
+  void setSharedLfo(const float *values) { sharedLfo = values; }
+  // Routing is owned by the engine and shared by every voice
+  void setModulationMatrix(const ModulationMatrix *matrix) {
+    modMatrix = matrix;
+  }
+  // Temporary buffers come from here; the voice rewinds it after rendering
+  void setScratchArena(ScratchArena *arena) { scratch = arena; }
   void prepare(double sampleRate, int samplesPerBlock);
 
   // Overrides for ADSR control
@@ -52,6 +105,8 @@ public:
                  juce::SynthesiserSound *sound,
                  int currentPitchWheelPosition) override;
   void stopNote(float velocity, bool allowTailOff) override;
+  // Silences the voice and lets go of its sound, one-shots included
+  void stopImmediately();
 
   // New Sample Params
   void updateSampleParams(float tune, float sampleStart, float sampleEnd,
@@ -64,16 +119,79 @@ public:
 
   // Custom ADSR access
   void updateADSR(float attack, float decay, float sustain, float release);
+  void setEnvelopeCurve(EnvelopeGenerator::Curve curve);
+
+  // Paraphonic mode: the voice is a bare sample player with a short declick
+  // gate. Filter, envelope and LFO are shared and applied on the summed bus.
+  void setParaphonic(bool shouldBeParaphonic,
+                     const EnvelopeGenerator *sharedEnv);
+  // When set, a release lets the voice ring on the shared envelope's release
+  // instead of its own gate (used for the last key lifted).
+  void setParaphonicHold(bool shouldHold) { paraphonicHold = shouldHold; }
+  void releaseParaphonicHold();
 
 private:
+  // Reads the interpolated sample into dest; returns the number of samples
+  // produced before the end of the sample data was reached. pitchMod, if
+  // given, holds a per-sample multiplier for the playback ratio.
+  int readSample(float *dest, int numSamples, const float *pitchMod);
+
+  // Destinations this voice applies itself (paraphonic voices only take
+  // pitch, the rest is applied on the shared bus)
+  int getModulationMask() const;
+
+  // Per-block modulation output in scratch memory: cutoff, gain and pitch
+  // hold per-sample factors, panPoints the pan position at each control
+  // point (gains are ramped in between)
+  struct ModulationCurves {
+    float *cutoff = nullptr;
+    float *gain = nullptr;
+    float *pitch = nullptr;
+    float *panPoints = nullptr;
+  };
+
+  // Evaluates the matrix every control interval and fills the curves for
+  // the destinations in mask
+  void renderModulation(int mask, const float *lfoValues,
+                        const float *envValues, int numSamples,
+                        const ModulationCurves &curves);
+  // True when the voice filter is not run at all: paraphonic voices, and an
+  // unmodulated lowpass fully open with no resonant peak
+  bool isFilterBypassed(int modMask) const;
+  // Drum/FX fast path: a one-shot playing at its own rate with no
+  // modulation and the filter bypassed is mixed straight from the sample
+  // data, times the envelope, with one gain per channel
+  bool canUseFastPath(int modMask) const;
+  // End-of-voice check shared by both paths (may release a paraphonic hold)
+  bool hasFinished(bool sampleFinished);
+  void renderFastPath(juce::AudioBuffer<float> &outputBuffer, int startSample,
+                      int numSamples);
+
+  // Mixes a mono signal into the output with constant-power panning,
+  // following panPoints if the pan is modulated (nullptr otherwise)
+  void addPanned(juce::AudioBuffer<float> &outputBuffer, int startSample,
+                 const float *source, int numSamples,
+                 const float *panPoints);
+
+  // Playback state
+  const HowlingSound *playingSound = nullptr;
+  double pitchRatio = 1.0;
+  double sourceSamplePosition = 0.0;
+  float velocityGain = 1.0f;
+
   juce::dsp::StateVariableTPTFilter<float> filter;
-  juce::dsp::Oscillator<float> lfo; // For filter modulation
-  float lfoDepth = 0.0f;
+  FormantBank formants; // Filter type 4, in place of the SVF
+  LFOProcessor lfo; // For filter modulation (retrigger mode only)
+  const float *sharedLfo = nullptr;
+
+  // Modulation state carried from block to block
+  const ModulationMatrix *modMatrix = nullptr;
+  std::array<float, ModulationMatrix::numDestinations> lastModPoint{};
+  bool modPrimed = false;
   float pan = 0.0f; // -1.0 (Left) to 1.0 (Right)
 
-  juce::ADSR adsr;
+  EnvelopeGenerator adsr;
   juce::ADSR::Parameters adsrParams;
-  float lfoRate = 0.0f;
 
   // Sample Parameters
   float tuneSemitones = 0.0f;
@@ -87,13 +205,24 @@ private:
 
   // One-Shot processing
   bool isCurrentSoundOneShot = false;
+  bool inFastPath = false;
+  bool wasFilterBypassed = false;
 
   // Base parameters for modulation
   float baseCutoff = 20000.0f;
   float baseResonance = 0.1f;
+  int currentFilterType = 0;
   bool isNotch = false;
+  static constexpr int formantType = 4;
+
+  ScratchArena *scratch = nullptr;
 
-  juce::AudioBuffer<float> tempBuffer;
+  // Paraphonic state
+  bool paraphonic = false;
+  bool paraphonicHold = false;
+  const EnvelopeGenerator *sharedEnvelope = nullptr;
+  static constexpr float gateAttack = 0.002f;
+  static constexpr float gateRelease = 0.01f;
 
   JUCE_LEAK_DETECTOR(HowlingVoice)
 };
@@ -110,9 +239,14 @@ public:
   void initialize();
   void prepare(double sampleRate, int samplesPerBlock);
 
+  // Message/loader thread, instead of clearSounds: stops every voice and
+  // drops the sounds here, so the last reference to a sound (and the
+  // memory it has locked) is never let go on the audio thread
+  void releaseSounds();
+
   void updateParams(float attack, float decay, float sustain, float release,
                     float cutoff, float resonance, int filterType,
-                    float lfoRate, float lfoDepth);
+                    float vowel, float lfoRate, float lfoDepth);
 
   void updateSampleParams(float tune, float sampleStart, float sampleEnd,
                           bool loop);
@@ -121,8 +255,112 @@ public:
   void setPackMode(int size, float spread); // size 1-8, spread 0.0-1.0
 
   void noteOn(int midiChannel, int midiNoteNumber, float velocity) override;
+  void noteOff(int midiChannel, int midiNoteNumber, float velocity,
+               bool allowTailOff) override;
+  void handleSustainPedal(int midiChannel, bool isDown) override;
+
+  // Paraphonic engine mode: voices share one envelope (applied here) and one
+  // filter/LFO (applied by the processor on the summed bus)
+  void setParaphonic(bool shouldBeParaphonic);
+  bool isParaphonic() const { return paraphonic; }
+
+  // Modulation routing: the LFO goes to lfoTarget (a
+  // LFOProcessor::Target), envelope and velocity can each move the cutoff.
+  // In paraphonic mode the cutoff routes move the shared bus filter instead,
+  // from the shared envelope and the latest note's velocity.
+  void setModulation(int lfoWave, int newLfoTarget, float envToCutoff,
+                     float velToCutoff);
+
+  // Paraphonic bus filter: the envelope and velocity routes' cutoff offset
+  // in octaves at a sample position of the block last rendered
+  float getBusCutoffOctaves(int samplePosition) const;
+
+  // Scratch memory for the voices; must outlive the engine's use of it
+  void setScratchArena(ScratchArena *arena);
+
+  // Retrigger: every voice runs its own LFO, restarted on note-on.
+  // Otherwise one LFO is rendered per block and shared by all voices.
+  void setLfoRetrigger(bool shouldRetrigger) {
+    lfoRetrigger = shouldRetrigger;
+  }
+
+  // Decay/release shape for every voice and the shared envelope
+  void setEnvelopeCurve(EnvelopeGenerator::Curve curve);
+
+  // Render-loop batching. juce::Synthesiser splits the block at every MIDI
+  // event; events closer together than the grain are handled in one go, and
+  // continuous controller data is coalesced (and optionally snapped to the
+  // grain) before it reaches the voices.
+  void setRenderGrain(int minSubBlockSamples, bool quantizeControllers);
+  int getRenderGrain() const { return renderGrain; }
+
+  // Coalesces and quantizes controller events, then renders the block
+  void renderBlock(juce::AudioBuffer<float> &outputBuffer,
+                   juce::MidiBuffer &midiMessages, int numSamples);
+
+  // Nothing sounding: with no MIDI either, a block can be skipped
+  bool hasActiveVoices() const;
+  // Instead of renderBlock for a skipped block; keeps the free-running LFO
+  // in time
+  void skipBlock(int numSamples);
+
+protected:
+  void renderVoices(juce::AudioBuffer<float> &outputAudio, int startSample,
+                    int numSamples) override;
 
 private:
+  // Voices are created on the first prepare, not in the constructor, so
+  // hosts scanning or loading sessions don't pay for them
+  static constexpr int numVoices = 8;
+  void createVoices();
+
   int packSize = 1;
   float packSpread = 0.0f; // Detune and Pan spread amount
+
+  // --- Paraphonic ---
+  int countGatedVoices(int excludingNote) const;
+  void updateParaphonicGate();
+
+  bool paraphonic = false;
+  bool paraphonicGateOpen = false;
+  EnvelopeGenerator paraphonicEnvelope;
+  float paraphonicVelocity = 1.0f; // Latest note-on
+  // Shared envelope at each control point of the block, for the bus filter
+  std::vector<float> busEnvelopePoints;
+
+  // --- Modulation ---
+  ModulationMatrix modMatrix;
+  LFOProcessor::Waveform lfoWaveform = LFOProcessor::Sine;
+  int lfoTarget = LFOProcessor::FilterCutoff;
+  float envCutoffAmount = 0.0f;
+  float velCutoffAmount = 0.0f;
+
+  // --- Global LFO ---
+  void renderGlobalLfo(int numSamples);
+
+  bool lfoRetrigger = true;
+  LFOProcessor globalLfo;
+
+  ScratchArena *scratch = nullptr;
+
+  // --- MIDI batching ---
+  void coalesceControllers(juce::MidiBuffer &midiMessages);
+  void flushPendingControllers(int cellStart);
+
+  // Slots per channel: 0-127 CC, then pitch wheel and channel pressure
+  static constexpr int pitchWheelSlot = 128;
+  static constexpr int pressureSlot = 129;
+  static constexpr int numControlSlots = 130;
+
+  struct PendingControl {
+    int value = -1;
+    int samplePosition = -1;
+  };
+
+  int renderGrain = 32;
+  bool snapControllersToGrain = true;
+  juce::MidiBuffer batchedMidi;
+  std::array<PendingControl, 16 * numControlSlots> pendingControls;
+  std::array<int, 16 * numControlSlots> lastSentControls;
+  std::vector<int> dirtyControls; // Indices into pendingControls
 };
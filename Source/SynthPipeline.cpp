@@ -0,0 +1,103 @@
+#include "SynthPipeline.h"
+
+void SynthPipeline::prepare(int numChannels, int maximumBlockSize,
+                            size_t scratchBytes) {
+  maxBlockSize = maximumBlockSize;
+  latency = maximumBlockSize;
+
+  arena.prepare(scratchBytes);
+  stageBuffer.setSize(numChannels, maximumBlockSize);
+  // Holds the block in flight plus the one being rendered
+  ring.setSize(numChannels, latency + maximumBlockSize);
+  ringChannels = ring.getArrayOfWritePointers();
+  ringSize = ring.getNumSamples();
+  reset();
+}
+
+void SynthPipeline::reset() {
+  jassert(!batch.isRunning());
+
+  for (int ch = 0; ch < ring.getNumChannels(); ++ch)
+    juce::FloatVectorOperations::clear(ringChannels[ch], ringSize);
+  readPos = 0;
+  writePos = latency;
+  available = latency;
+}
+
+void SynthPipeline::beginBlock(juce::MidiBuffer &midi, int numSamples) {
+  jassert(!batch.isRunning());
+  jassert(numSamples <= maxBlockSize);
+
+  jobMidi = &midi;
+  jobSamples = juce::jmin(numSamples, maxBlockSize);
+
+  // Without a pool the render waits for the join
+  if (workers != nullptr && jobSamples > 0)
+    workers->start(batch, &SynthPipeline::renderTask, this, 1);
+}
+
+void SynthPipeline::readDelayed(juce::AudioBuffer<float> &dest) {
+  const int numSamples = dest.getNumSamples();
+
+  // Only short on the first block after a larger one; the render's output
+  // is needed straight away then
+  if (available < numSamples)
+    joinRender();
+
+  const int first = juce::jmin(numSamples, ringSize - readPos);
+  const int channels =
+      juce::jmin(dest.getNumChannels(), ring.getNumChannels());
+
+  for (int ch = 0; ch < channels; ++ch) {
+    auto *out = dest.getWritePointer(ch);
+    juce::FloatVectorOperations::copy(out, ringChannels[ch] + readPos, first);
+    juce::FloatVectorOperations::copy(out + first, ringChannels[ch],
+                                      numSamples - first);
+  }
+
+  readPos = (readPos + numSamples) % ringSize;
+  available -= numSamples;
+}
+
+void SynthPipeline::endBlock() { joinRender(); }
+
+void SynthPipeline::joinRender() {
+  if (jobSamples == 0)
+    return;
+
+  // Runs it here if no worker has claimed it
+  if (workers != nullptr)
+    workers->join(batch);
+  else
+    render();
+
+  writePos = (writePos + jobSamples) % ringSize;
+  available += jobSamples;
+  jobSamples = 0;
+}
+
+void SynthPipeline::renderTask(void *context, int) {
+  static_cast<SynthPipeline *>(context)->render();
+}
+
+void SynthPipeline::render() {
+  arena.reset();
+
+  // Refers to the first jobSamples of the stage buffer, no allocation
+  juce::AudioBuffer<float> block(stageBuffer.getArrayOfWritePointers(),
+                                 stageBuffer.getNumChannels(), jobSamples);
+  block.clear();
+
+  if (renderStage)
+    renderStage(block, *jobMidi);
+
+  // Append after the samples the audio thread may be reading
+  const int first = juce::jmin(jobSamples, ringSize - writePos);
+
+  for (int ch = 0; ch < ring.getNumChannels(); ++ch) {
+    const auto *in = block.getReadPointer(ch);
+    juce::FloatVectorOperations::copy(ringChannels[ch] + writePos, in, first);
+    juce::FloatVectorOperations::copy(ringChannels[ch], in + first,
+                                      jobSamples - first);
+  }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ScratchArena.h"
+#include "WorkerPool.h"
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Runs the synth stage on a worker of the shared pool, one block ahead of
+    the effects. Each processBlock hands the pool this block's MIDI
+    (beginBlock), pulls the synth output rendered one prepared block earlier
+    (readDelayed), runs the effects on it while a worker renders, then joins
+    (endBlock). Costs exactly one block of latency, which the processor
+    reports to the host.
+
+    The render has its own scratch arena, so the synth stage and the effects
+    never share temporary memory. Pipelining only pays off once the pool's
+    workers are running; the processor asks for them when it is switched
+    on, so instances that never use it don't carry an idle realtime thread.
+*/
+class SynthPipeline {
+public:
+  // Renders the synth into a cleared buffer (runs on a worker)
+  using RenderStage =
+      std::function<void(juce::AudioBuffer<float> &, juce::MidiBuffer &)>;
+
+  SynthPipeline() = default;
+
+  // Message thread: set once, before prepare
+  void setRenderStage(RenderStage stage) { renderStage = std::move(stage); }
+  // Message thread, while the audio thread is stopped
+  void setWorkerPool(WorkerPool *pool) { workers = pool; }
+
+  // Message thread: allocates everything
+  void prepare(int numChannels, int maximumBlockSize, size_t scratchBytes);
+
+  // Audio thread: blocks can be pipelined once the workers are up
+  bool isRunning() const {
+    return workers != nullptr && workers->hasWorkers();
+  }
+
+  int getLatencySamples() const { return latency; }
+  int getMaximumBlockSize() const { return maxBlockSize; }
+  ScratchArena &getArena() { return arena; }
+
+  // Audio thread: back to one block of silence in flight
+  void reset();
+
+  // Audio thread, in this order, once per block. The MIDI buffer must stay
+  // untouched until endBlock.
+  void beginBlock(juce::MidiBuffer &midi, int numSamples);
+  void readDelayed(juce::AudioBuffer<float> &dest);
+  void endBlock();
+
+private:
+  static void renderTask(void *context, int index);
+  void render();
+  void joinRender();
+
+  RenderStage renderStage;
+  ScratchArena arena;
+  WorkerPool *workers = nullptr;
+  WorkerPool::Batch batch;
+
+  // Render input/output, handed over by the batch's start and join
+  juce::AudioBuffer<float> stageBuffer;
+  juce::MidiBuffer *jobMidi = nullptr;
+  int jobSamples = 0;
+
+  // Synth output waiting for the effects. Only the audio thread moves the
+  // positions; the render writes after `available` while it runs. Both
+  // sides go through the raw channel pointers, never the AudioBuffer (its
+  // clear flag is not thread safe).
+  juce::AudioBuffer<float> ring;
+  float *const *ringChannels = nullptr;
+  int ringSize = 0;
+  int readPos = 0;
+  int writePos = 0;
+  int available = 0;
+
+  int latency = 0;
+  int maxBlockSize = 0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SynthPipeline)
+};
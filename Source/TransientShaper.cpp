@@ -1,82 +1,222 @@
 #include "TransientShaper.h"
 
+static float followerCoeff(float ms, float sampleRate) {
+  return std::exp(-1000.0f / (ms * sampleRate));
+}
+
+// 1 + the scaled transient, limited to 0.1 .. 4 (min/max, no branch)
+static inline float toGain(float boost) {
+  const float gain = 1.0f + boost;
+  return std::min(std::max(gain, 0.1f), 4.0f);
+}
+
 TransientShaper::TransientShaper() {}
 
-void TransientShaper::prepare(const juce::dsp::ProcessSpec &spec) {
+void TransientShaper::prepare(const juce::dsp::ProcessSpec &spec,
+                              int maxGainDelay) {
   sampleRate = (float)spec.sampleRate;
+  numPreparedChannels = (int)spec.numChannels;
 
-  fastEnvs.resize(spec.numChannels);
-  slowEnvs.resize(spec.numChannels);
+  const int numPairs = (numPreparedChannels + 1) / 2;
+  envelopes.assign((size_t)numPairs * 4, 0.0f);
+  lastGain.assign((size_t)numPreparedChannels, 1.0f);
 
+  lookaheadSamples = juce::roundToInt(lookaheadMs * 0.001f * sampleRate);
+  lookaheadBuffer.setSize(numPreparedChannels, juce::jmax(1, lookaheadSamples));
+  gainDelayBuffer.setSize(numPreparedChannels, juce::jmax(1, maxGainDelay));
+  gainDelaySamples = juce::jmin(gainDelaySamples, maxGainDelay);
+
+  biteAmount.reset(sampleRate, 0.05);
   setAttackSpeed(fastAttackMs, slowAttackMs);
   reset();
 }
 
 void TransientShaper::reset() {
-  for (auto &env : fastEnvs)
-    env.reset();
-  for (auto &env : slowEnvs)
-    env.reset();
+  std::fill(envelopes.begin(), envelopes.end(), 0.0f);
+  std::fill(lastGain.begin(), lastGain.end(), 1.0f);
+  lookaheadBuffer.clear();
+  lookaheadPos = 0;
+  clearGainDelay();
+}
+
+void TransientShaper::clearGainDelay() {
+  for (int ch = 0; ch < gainDelayBuffer.getNumChannels(); ++ch)
+    juce::FloatVectorOperations::fill(gainDelayBuffer.getWritePointer(ch),
+                                      1.0f, gainDelayBuffer.getNumSamples());
+  gainDelayPos = 0;
 }
 
 void TransientShaper::setAttackSpeed(float fastMs, float slowMs) {
   fastAttackMs = fastMs;
   slowAttackMs = slowMs;
 
-  for (auto &env : fastEnvs)
-    env.setCoefficients(fastAttackMs, releaseMs, sampleRate);
-  for (auto &env : slowEnvs)
-    env.setCoefficients(slowAttackMs, releaseMs, sampleRate);
+  fastAttackCoeff = followerCoeff(fastAttackMs, sampleRate);
+  slowAttackCoeff = followerCoeff(slowAttackMs, sampleRate);
+  releaseCoeff = followerCoeff(releaseMs, sampleRate);
 }
 
-void TransientShaper::process(juce::AudioBuffer<float> &buffer) {
-  // Always process if smoothing or active
-  if (std::abs(biteAmount.getCurrentValue()) < 0.01f &&
-      !biteAmount.isSmoothing() &&
-      std::abs(biteAmount.getTargetValue()) < 0.01f)
+void TransientShaper::setLookahead(bool enabled) {
+  if (enabled == lookahead)
     return;
 
-  auto numChannels = buffer.getNumChannels();
-  auto numSamples = buffer.getNumSamples();
-
-  // Resize safety
-  if (fastEnvs.size() != numChannels) {
-    fastEnvs.resize(numChannels);
-    slowEnvs.resize(numChannels);
-    setAttackSpeed(fastAttackMs, slowAttackMs);
-    // Reset envs
-    for (auto &env : fastEnvs)
-      env.reset();
-    for (auto &env : slowEnvs)
-      env.reset();
+  lookahead = enabled;
+  lookaheadBuffer.clear();
+  lookaheadPos = 0;
+}
+
+void TransientShaper::setGainDelay(int samples) {
+  samples = juce::jlimit(0, gainDelayBuffer.getNumSamples(), samples);
+  if (samples == gainDelaySamples)
+    return;
+
+  gainDelaySamples = samples;
+  clearGainDelay();
+}
+
+void TransientShaper::delayGains(float *const *gains, int numChannels,
+                                 int numSamples) {
+  if (gainDelaySamples == 0)
+    return;
+
+  const int channels =
+      juce::jmin(numChannels, gainDelayBuffer.getNumChannels());
+
+  for (int ch = 0; ch < channels; ++ch) {
+    auto *gain = gains[ch];
+    auto *line = gainDelayBuffer.getWritePointer(ch);
+    int pos = gainDelayPos;
+
+    for (int i = 0; i < numSamples; ++i) {
+      std::swap(gain[i], line[pos]);
+      if (++pos == gainDelaySamples)
+        pos = 0;
+    }
+  }
+
+  gainDelayPos = (gainDelayPos + numSamples) % gainDelaySamples;
+}
+
+void TransientShaper::analyse(const juce::AudioBuffer<float> &input,
+                              float *const *gains) {
+  const int numSamples = input.getNumSamples();
+  const int numChannels =
+      juce::jmin(input.getNumChannels(), numPreparedChannels);
+  if (numSamples == 0 || numChannels == 0)
+    return;
+
+  jassert(scratch != nullptr);
+  ScratchArena::ScopedRewind rewind(*scratch);
+  auto bite = ParameterRamp::next(biteAmount, *scratch, numSamples);
+
+  for (int a = 0; a < numChannels; a += 2) {
+    const int b = juce::jmin(a + 1, numChannels - 1);
+    analysePair(input.getReadPointer(a), input.getReadPointer(b), gains[a],
+                gains[b], envelopes.data() + a * 2, numSamples);
   }
 
-  auto *ch0 = buffer.getWritePointer(0);
-  auto *ch1 = (numChannels > 1) ? buffer.getWritePointer(1) : nullptr;
+  // Transient to gain: 1 + 2 * bite * transient, kept in range. One plain
+  // pass per channel, out of the recursive loop, so it vectorises over time.
+  for (int ch = 0; ch < numChannels; ++ch) {
+    auto *gain = gains[ch];
+
+    if (bite.isConstant()) {
+      const float amount = 2.0f * bite.value;
+      for (int i = 0; i < numSamples; ++i)
+        gain[i] = toGain(amount * gain[i]);
+    } else {
+      for (int i = 0; i < numSamples; ++i)
+        gain[i] = toGain(2.0f * bite.values[i] * gain[i]);
+    }
+  }
+}
+
+void TransientShaper::analysePair(const float *a, const float *b,
+                                  float *transientA, float *transientB,
+                                  float *state, int numSamples) const {
+  alignas(16) float env[4] = {state[0], state[1], state[2], state[3]};
+  alignas(16) const float attack[4] = {fastAttackCoeff, fastAttackCoeff,
+                                       slowAttackCoeff, slowAttackCoeff};
+  alignas(16) const float attackIn[4] = {1.0f - attack[0], 1.0f - attack[1],
+                                         1.0f - attack[2], 1.0f - attack[3]};
+  const float release = releaseCoeff;
+  const float releaseIn = 1.0f - releaseCoeff;
 
   for (int i = 0; i < numSamples; ++i) {
-    float bite = biteAmount.getNextValue();
-
-    // Ch 0
-    {
-      float input = ch0[i];
-      float fast = fastEnvs[0].process(input);
-      float slow = slowEnvs[0].process(input);
-      float transient = fast - slow;
-      float gainChange = 1.0f + (transient * bite * 2.0f);
-      gainChange = juce::jlimit(0.1f, 4.0f, gainChange);
-      ch0[i] = input * gainChange;
+    const float absA = std::abs(a[i]);
+    const float absB = std::abs(b[i]);
+    alignas(16) const float in[4] = {absA, absB, absA, absB};
+
+    // Both outcomes, then a select: fixed trip counts and no branch, so
+    // each line is one vector op, and the compare runs alongside the
+    // multiply-adds instead of ahead of them
+    alignas(16) float rising[4], falling[4];
+    for (int k = 0; k < 4; ++k) {
+      rising[k] = attack[k] * env[k] + attackIn[k] * in[k];
+      falling[k] = release * env[k] + releaseIn * in[k];
+    }
+    for (int k = 0; k < 4; ++k)
+      env[k] = in[k] > env[k] ? rising[k] : falling[k];
+
+    // b first: when it aliases a, a's own lanes have the last word
+    transientB[i] = env[1] - env[3];
+    transientA[i] = env[0] - env[2];
+  }
+
+  std::copy(env, env + 4, state);
+}
+
+void TransientShaper::delay(juce::AudioBuffer<float> &buffer) {
+  if (!lookahead || lookaheadSamples == 0)
+    return;
+
+  const int numSamples = buffer.getNumSamples();
+  const int channels =
+      juce::jmin(buffer.getNumChannels(), lookaheadBuffer.getNumChannels());
+
+  for (int ch = 0; ch < channels; ++ch) {
+    auto *data = buffer.getWritePointer(ch);
+    auto *line = lookaheadBuffer.getWritePointer(ch);
+    int pos = lookaheadPos;
+
+    for (int i = 0; i < numSamples; ++i) {
+      std::swap(data[i], line[pos]);
+      if (++pos == lookaheadSamples)
+        pos = 0;
     }
+  }
+
+  lookaheadPos = (lookaheadPos + numSamples) % lookaheadSamples;
+}
+
+void TransientShaper::applyGains(juce::dsp::AudioBlock<float> &block,
+                                 const float *const *gains, int order) {
+  const int numChannels =
+      juce::jmin((int)block.getNumChannels(), numPreparedChannels);
+  const int factor = 1 << order;
+  const int numSamples = (int)block.getNumSamples() >> order;
+  if (numSamples == 0)
+    return;
 
-    // Ch 1
-    if (ch1) {
-      float input = ch1[i];
-      float fast = fastEnvs[1].process(input);
-      float slow = slowEnvs[1].process(input);
-      float transient = fast - slow;
-      float gainChange = 1.0f + (transient * bite * 2.0f);
-      gainChange = juce::jlimit(0.1f, 4.0f, gainChange);
-      ch1[i] = input * gainChange;
+  for (int ch = 0; ch < numChannels; ++ch) {
+    auto *data = block.getChannelPointer((size_t)ch);
+    const auto *gain = gains[ch];
+
+    if (order == 0) {
+      juce::FloatVectorOperations::multiply(data, gain, numSamples);
+    } else {
+      // Each base-rate gain is reached at the end of its 2^order samples
+      float previous = lastGain[(size_t)ch];
+      const float scale = 1.0f / (float)factor;
+
+      for (int i = 0; i < numSamples; ++i) {
+        const float step = (gain[i] - previous) * scale;
+        auto *span = data + (i << order);
+        for (int k = 0; k < factor; ++k)
+          span[k] *= previous + step * (float)(k + 1);
+        previous = gain[i];
+      }
     }
+
+    lastGain[(size_t)ch] = gain[numSamples - 1];
   }
 }
@@ -1,15 +1,49 @@
 #pragma once
+#include "ParameterRamp.h"
+#include "ScratchArena.h"
 #include <JuceHeader.h>
 
+//==============================================================================
+/**
+    Transient shaper ("Bite"): a fast and a slow envelope follower per
+    channel, whose difference is the transient. Bite turns it into a gain
+    boost (punch) or cut (soften).
+
+    Split so the oversampled stage only does what needs the higher rate:
+    analyse() runs the followers at the base rate and writes a gain per
+    sample and channel, applyGains() multiplies the oversampled audio by
+    them, interpolated up.
+
+    Two channels' followers (fast and slow each) are four lanes updated
+    together, the attack/release choice a select rather than a branch, so
+    each sample is one 4-wide vector step for any channel count.
+
+    With lookahead on, the audio runs a couple of milliseconds behind the
+    followers, so the gain is already up when an attack arrives instead of
+    catching it part way through.
+
+    The oversampler's up filter delays the audio before the gains reach
+    it, so the gains wait as long again (see setGainDelay) and shaping
+    lands on the transient rather than after it.
+*/
 class TransientShaper {
 public:
+  static constexpr float lookaheadMs = 2.0f; // About the fast attack
+
   TransientShaper();
 
-  void prepare(const juce::dsp::ProcessSpec &spec);
+  // All per-channel state is sized here, for spec.numChannels, with room
+  // for a gain delay of up to maxGainDelay samples
+  void prepare(const juce::dsp::ProcessSpec &spec, int maxGainDelay);
   void reset();
+  void setScratchArena(ScratchArena *arena) { scratch = arena; }
 
-  // Process a block
-  void process(juce::AudioBuffer<float> &buffer);
+  // False while the amount is (and stays) at zero
+  bool isActive() const {
+    return std::abs(biteAmount.getCurrentValue()) >= 0.01f ||
+           biteAmount.isSmoothing() ||
+           std::abs(biteAmount.getTargetValue()) >= 0.01f;
+  }
 
   // Parameters
   // Amount: -1.0 (Soften) to 1.0 (Punch)
@@ -18,39 +52,62 @@ public:
   // Speed definitions (optional control)
   void setAttackSpeed(float fastMs, float slowMs);
 
+  // Changes the latency; clears the lookahead delay
+  void setLookahead(bool enabled);
+  int getLatencySamples() const { return lookahead ? lookaheadSamples : 0; }
+
+  // Followers over the undelayed input, one gain per sample into gains[ch]
+  // for each channel up to the prepared count
+  void analyse(const juce::AudioBuffer<float> &input, float *const *gains);
+
+  // Base-rate samples the gains are held back by: the oversampler's up
+  // filter latency. A change starts the delay over at unity gain.
+  void setGainDelay(int samples);
+  // Run on the gains from analyse() before applyGains()
+  void delayGains(float *const *gains, int numChannels, int numSamples);
+
+  // The lookahead delay (nothing with it off). Runs on bypassed blocks too,
+  // so the latency never depends on the amount.
+  void delay(juce::AudioBuffer<float> &buffer);
+
+  // Multiplies a block running at 2^order times the base rate by the gains
+  // from analyse(), ramping linearly from one to the next
+  void applyGains(juce::dsp::AudioBlock<float> &block,
+                  const float *const *gains, int order);
+
 private:
+  // Refills the gain delay with unity
+  void clearGainDelay();
+
+  // Fast minus slow envelope for channels a and b, which share one set of
+  // four lanes; b == a for a leftover odd channel
+  void analysePair(const float *a, const float *b, float *transientA,
+                   float *transientB, float *state, int numSamples) const;
+
+  ScratchArena *scratch = nullptr;
+
   float sampleRate = 44100.0f;
+  int numPreparedChannels = 0;
   juce::LinearSmoothedValue<float> biteAmount;
 
-  // Envelope followers
-  // We can use simple one-pole filters for envelopes logic
-  // env = prev + coeff * (in - prev)
-
-  struct EnvelopeFollower {
-    float value = 0.0f;
-    float attackCoeff = 0.0f;
-    float releaseCoeff = 0.0f;
-
-    void setCoefficients(float attackMs, float releaseMsArg, float sr) {
-      attackCoeff = std::exp(-1000.0f / (attackMs * sr));
-      releaseCoeff = std::exp(-1000.0f / (releaseMsArg * sr));
-    }
-
-    float process(float input) {
-      float absIn = std::abs(input);
-      if (absIn > value)
-        value = attackCoeff * value + (1.0f - attackCoeff) * absIn;
-      else
-        value = releaseCoeff * value + (1.0f - releaseCoeff) * absIn;
-      return value;
-    }
-
-    void reset() { value = 0.0f; }
-  };
-
-  // Per-channel state
-  std::vector<EnvelopeFollower> fastEnvs;
-  std::vector<EnvelopeFollower> slowEnvs;
+  // One-pole followers: env = coeff * env + (1 - coeff) * in
+  float fastAttackCoeff = 0.0f;
+  float slowAttackCoeff = 0.0f;
+  float releaseCoeff = 0.0f;
+
+  // Per channel pair: fast a, fast b, slow a, slow b
+  std::vector<float> envelopes;
+  // Per channel: where the last block's gain ramp ended
+  std::vector<float> lastGain;
+
+  juce::AudioBuffer<float> gainDelayBuffer;
+  int gainDelaySamples = 0;
+  int gainDelayPos = 0;
+
+  juce::AudioBuffer<float> lookaheadBuffer;
+  int lookaheadSamples = 0;
+  int lookaheadPos = 0;
+  bool lookahead = false;
 
   float fastAttackMs = 2.0f;
   float slowAttackMs = 20.0f; // Difference defines transient width
@@ -0,0 +1,183 @@
+#include "WorkerPool.h"
+
+namespace {
+constexpr int indexBits = 8;
+constexpr int indexMask = (1 << indexBits) - 1;
+} // namespace
+
+//==============================================================================
+class WorkerPool::Worker : public juce::Thread {
+public:
+  explicit Worker(WorkerPool &owner) : juce::Thread("FX Worker"), pool(owner) {}
+
+  ~Worker() override {
+    signalThreadShouldExit();
+    wake();
+    stopThread(1000);
+  }
+
+  void wake() { wakeEvent.signal(); }
+
+  void run() override {
+    juce::ScopedNoDenormals noDenormals;
+
+    while (!threadShouldExit()) {
+      wakeEvent.wait();
+      if (threadShouldExit())
+        break;
+
+      // Woken late, the batches may be long done: then there's nothing
+      // left to claim. Goes round until every batch out is claimed.
+      while (pool.runAvailable())
+        ;
+    }
+  }
+
+private:
+  WorkerPool &pool;
+  juce::WaitableEvent wakeEvent;
+
+  JUCE_DECLARE_NON_COPYABLE(Worker)
+};
+
+//==============================================================================
+WorkerPool::WorkerPool() = default;
+
+WorkerPool::~WorkerPool() {
+  cancelPendingUpdate();
+  release();
+}
+
+void WorkerPool::prepare(int numWorkers, double sampleRate,
+                         int maximumBlockSize) {
+  release();
+
+  preparedSampleRate = sampleRate;
+  maxBlockSize = maximumBlockSize;
+
+  // Created here, so the audio thread never sees the list change; only
+  // started when asked for
+  for (int i = 0; i < numWorkers; ++i)
+    workers.push_back(std::make_unique<Worker>(*this));
+
+  if (requested.load())
+    startWorkers();
+}
+
+void WorkerPool::release() {
+  running = false;
+  workers.clear();
+
+  for (auto &slot : slots)
+    slot.store(nullptr);
+}
+
+void WorkerPool::startWorkers() {
+  for (auto &worker : workers) {
+    if (worker->isThreadRunning())
+      continue;
+
+    // Falls back to a normal high priority thread where realtime
+    // scheduling isn't allowed
+    if (!worker->startRealtimeThread(
+            juce::Thread::RealtimeOptions{}.withApproximateAudioProcessingTime(
+                maxBlockSize, preparedSampleRate)))
+      worker->startThread(juce::Thread::Priority::highest);
+  }
+
+  requested = true;
+  running = true;
+}
+
+void WorkerPool::requestWorkers() {
+  if (!requested.exchange(true))
+    triggerAsyncUpdate();
+}
+
+void WorkerPool::handleAsyncUpdate() { startWorkers(); }
+
+void WorkerPool::start(Batch &batch, Task task, void *context,
+                       int numTasks) {
+  jassert(!batch.running);
+  jassert(numTasks >= 0 && numTasks <= maxTasks);
+
+  batch.task = task;
+  batch.context = context;
+  batch.size = juce::jlimit(0, maxTasks, numTasks);
+  batch.running = true;
+
+  batch.finished.store(0, std::memory_order_relaxed);
+  batch.state.store(batch.size << indexBits, std::memory_order_release);
+
+  // No free slot only if more users than maxBatches: then the caller runs
+  // it all at the join
+  for (int i = 0; i < maxBatches && batch.slot < 0; ++i) {
+    Batch *expected = nullptr;
+    if (slots[(size_t)i].compare_exchange_strong(expected, &batch,
+                                                 std::memory_order_acq_rel))
+      batch.slot = i;
+  }
+  jassert(batch.slot >= 0);
+
+  // Every worker: one busy with another batch picks this one up when it's
+  // done, and any the caller beats to it goes back to sleep
+  if (running.load())
+    for (auto &worker : workers)
+      worker->wake();
+}
+
+void WorkerPool::join(Batch &batch) {
+  if (!batch.running)
+    return;
+
+  for (int index = claim(batch); index >= 0; index = claim(batch))
+    runClaimed(batch, index);
+
+  // Only tasks already running on a worker are left: spin, they are short
+  for (int spins = 0;
+       batch.finished.load(std::memory_order_acquire) < batch.size; ++spins) {
+    if (spins > 1000)
+      juce::Thread::yield();
+  }
+
+  if (batch.slot >= 0)
+    slots[(size_t)batch.slot].store(nullptr, std::memory_order_release);
+  batch.slot = -1;
+  batch.running = false;
+}
+
+int WorkerPool::claim(Batch &batch) {
+  int current = batch.state.load(std::memory_order_acquire);
+
+  for (;;) {
+    const int next = current & indexMask;
+    if (next >= (current >> indexBits))
+      return -1;
+
+    if (batch.state.compare_exchange_weak(current, current + 1,
+                                          std::memory_order_acq_rel))
+      return next;
+  }
+}
+
+void WorkerPool::runClaimed(Batch &batch, int index) {
+  batch.task(batch.context, index);
+  batch.finished.fetch_add(1, std::memory_order_release);
+}
+
+bool WorkerPool::runAvailable() {
+  bool ranAny = false;
+
+  for (auto &slot : slots) {
+    auto *batch = slot.load(std::memory_order_acquire);
+    if (batch == nullptr)
+      continue;
+
+    for (int index = claim(*batch); index >= 0; index = claim(*batch)) {
+      runClaimed(*batch, index);
+      ranAny = true;
+    }
+  }
+
+  return ranAny;
+}
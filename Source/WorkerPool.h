@@ -0,0 +1,98 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A few realtime threads shared by all of an instance's parallel work:
+    the effects' sends, the pipelined synth stage and the convolution tail.
+    Each user owns a Batch of independent tasks, which it hands to the pool
+    and joins again later, several batches being out at once.
+
+    start() publishes the batch and wakes the workers; the caller is then
+    free to carry on with its own work. join() runs any task nobody has
+    claimed yet on the calling thread and spins until the claimed ones are
+    done, so a worker that wakes late (or is busy with another batch) never
+    holds the caller up by more than the task it is already running.
+    Claiming a task is a single compare-and-swap; nothing locks or
+    allocates after prepare.
+
+    The threads are only started once something asks for them, so an
+    instance that never runs anything in parallel carries none. Until then
+    join() simply runs every task on the caller.
+*/
+class WorkerPool : private juce::AsyncUpdater {
+public:
+  // Runs task `index` of a batch
+  using Task = void (*)(void *context, int index);
+
+  static constexpr int maxTasks = 255;
+  // Batches that can be out at the same time
+  static constexpr int maxBatches = 4;
+
+  // One user's tasks. Started and joined in turn, one batch at a time, by
+  // whichever thread the user runs on.
+  class Batch {
+  public:
+    Batch() = default;
+    bool isRunning() const { return running; }
+
+  private:
+    friend class WorkerPool;
+
+    // Written before the state that publishes them and left alone until
+    // the batch is joined
+    Task task = nullptr;
+    void *context = nullptr;
+    int size = 0;
+    bool running = false;
+    int slot = -1;
+
+    // Task count in the high bits, next unclaimed index in the low ones,
+    // so a claim can never land on a batch other than the one it read
+    std::atomic<int> state{0};
+    std::atomic<int> finished{0};
+
+    JUCE_DECLARE_NON_COPYABLE(Batch)
+  };
+
+  WorkerPool();
+  ~WorkerPool() override;
+
+  // Message thread: sets up numWorkers threads, started straight away if
+  // they have been asked for before
+  void prepare(int numWorkers, double sampleRate, int maximumBlockSize);
+  void release();
+  int getNumWorkers() const { return (int)workers.size(); }
+
+  // Message thread: starts the workers if they aren't running
+  void startWorkers();
+  // Any thread: has the message thread start them. Cheap once asked.
+  void requestWorkers();
+  bool hasWorkers() const { return running.load(); }
+
+  void start(Batch &batch, Task task, void *context, int numTasks);
+  void join(Batch &batch);
+
+private:
+  class Worker;
+
+  void handleAsyncUpdate() override;
+
+  // Claims the next task of a batch, or -1 once all are claimed
+  static int claim(Batch &batch);
+  static void runClaimed(Batch &batch, int index);
+  // Worker side: runs whatever it can claim. False if there was nothing.
+  bool runAvailable();
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  double preparedSampleRate = 44100.0;
+  int maxBlockSize = 0;
+  std::atomic<bool> requested{false};
+  std::atomic<bool> running{false};
+
+  // The batches out now, for the workers to claim from
+  std::array<std::atomic<Batch *>, maxBatches> slots{};
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WorkerPool)
+};